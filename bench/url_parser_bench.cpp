@@ -0,0 +1,125 @@
+/**
+ *  Compares the single-pass ReducedUrlParser with the regex parser it replaced.
+ *  The regex parser compiled its expressions on every call, which dominates its time.
+ *
+ *  Build with -DSIMPLEREST_BUILD_BENCHMARKS=ON and run ./url_parser_bench [iterations].
+ */
+
+#include "../url_parser.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+//#######################################################################################################
+    /**
+     *  The former ReducedUrlParser::parseQuery, unchanged.
+     */
+    void legacyParseQuery(std::string const& query, Rest::Url& url)
+    {
+        std::regex rgx( R"((\w+=(?:[\w-])+)(?:(?:&|;)(\w+=(?:[\w-])+))*)" );
+        std::smatch match;
+
+        if (std::regex_match(query, match, rgx))
+        {
+            for (auto i = std::begin(match) + 1; i < std::end(match); ++i)
+            {
+                auto pos = i->str().find_first_of('=');
+                url.query[i->str().substr(pos+1)] = i->str().substr(0, pos);
+            }
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    /**
+     *  The former ReducedUrlParser::parse, unchanged.
+     */
+    Rest::Url legacyParse(std::string const& urlString)
+    {
+        Rest::Url url;
+        url.url = urlString;
+
+        std::regex rgx( R"((?:(?:(\/(?:(?:[a-zA-Z0-9]|[-_~!$&']|[()]|[*+,;=:@])+(?:\/(?:[a-zA-Z0-9]|[-_~!$&']|[()]|[*+,;=:@])+)*)?)|\/)?(?:(\?(?:\w+=(?:[\w-])+)(?:(?:&|;)(?:\w+=(?:[\w-])+))*))?(?:(#(?:\w|\d|=|\(|\)|\\|\/|:|,|&|\?)+))?))" );
+        std::smatch match;
+
+        if (std::regex_match(urlString, match, rgx))
+        {
+            for (auto i = std::begin(match) + 1; i < std::end(match); ++i)
+            {
+                if (i->str().front() == '/')
+                    url.path = i->str();
+                else if (i->str().front() == '?')
+                    legacyParseQuery(i->str().substr(1, i->str().length() - 1), url);
+                else if (i->str().front() == '#')
+                    url.fragment = i->str().substr(1, i->str().length() - 1);
+            }
+        }
+        else
+            throw std::invalid_argument("Not a valid sub url");
+
+        return url;
+    }
+//-------------------------------------------------------------------------------------------------------
+    /**
+     *  Runs the parser over all targets and returns the nanoseconds per parse.
+     */
+    template <typename ParserT>
+    double measure(std::vector <std::string> const& targets, std::size_t iterations, ParserT&& parser)
+    {
+        std::size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i != iterations; ++i)
+        {
+            for (auto const& target : targets)
+            {
+                auto url = parser(target);
+                sink += url.path.size() + url.query.size();
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        // keeps the results alive, so that the parsing is not optimized away.
+        if (sink == 0)
+            std::cerr << "nothing parsed\n";
+
+        return std::chrono::duration <double, std::nano> (elapsed).count() / static_cast <double> (iterations * targets.size());
+    }
+//#######################################################################################################
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+
+    // targets both parsers accept: the regex one rejects '.' in paths, percent-encoding and most punctuation in queries.
+    std::vector <std::string> const targets {
+        "/",
+        "/index",
+        "/api/v1/users/12345",
+        "/api/v1/users/12345/files/report-2024",
+        "/search?q=simple&page=2",
+        "/api/v1/items?sort=desc&limit=50&offset=100",
+        "/assets/css/site#top",
+        "/api/v1/users/12345/files?type=pdf;owner=me#section"
+    };
+
+    for (auto const& target : targets)
+    {
+        if (legacyParse(target).path != Rest::ReducedUrlParser::parse(target).path)
+            std::cerr << "paths differ for " << target << "\n";
+    }
+
+    auto legacy = measure(targets, iterations, [](std::string const& target) { return legacyParse(target); });
+    auto current = measure(targets, iterations, [](std::string const& target) { return Rest::ReducedUrlParser::parse(target); });
+
+    std::cout << "targets:     " << targets.size() << " x " << iterations << "\n";
+    std::cout << "regex:       " << legacy << " ns/parse\n";
+    std::cout << "single-pass: " << current << " ns/parse\n";
+    std::cout << "speedup:     " << legacy / current << "x\n";
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "byte_range.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <limits>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        void skipWhitespace(boost::string_view& text)
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+                text.remove_prefix(1);
+        }
+
+        /**
+         *  @return false if there is no number or it overflows.
+         */
+        bool parseNumber(boost::string_view& text, std::uint64_t& number)
+        {
+            if (text.empty() || text.front() < '0' || text.front() > '9')
+                return false;
+
+            number = 0;
+            while (!text.empty() && text.front() >= '0' && text.front() <= '9')
+            {
+                auto digit = static_cast <std::uint64_t> (text.front() - '0');
+                if (number > (std::numeric_limits <std::uint64_t>::max() - digit) / 10)
+                    return false;
+                number = number * 10 + digit;
+                text.remove_prefix(1);
+            }
+            return true;
+        }
+    }
+//#######################################################################################################
+    RangeResult parseByteRanges(boost::string_view value, std::uint64_t size, std::vector <ByteRange>& ranges)
+    {
+        ranges.clear();
+
+        auto equals = value.find('=');
+        if (equals == boost::string_view::npos || !boost::algorithm::iequals(value.substr(0, equals), "bytes"))
+            return RangeResult::Full;
+        value.remove_prefix(equals + 1);
+
+        std::size_t specifiers = 0;
+        for (;;)
+        {
+            skipWhitespace(value);
+
+            // empty list elements are allowed.
+            if (!value.empty() && value.front() == ',')
+            {
+                value.remove_prefix(1);
+                continue;
+            }
+            if (value.empty())
+                break;
+
+            if (++specifiers > maxByteRanges)
+                return RangeResult::Full;
+
+            std::uint64_t first = 0;
+            std::uint64_t last = 0;
+            if (value.front() == '-')
+            {
+                // the last n bytes.
+                value.remove_prefix(1);
+                std::uint64_t suffix;
+                if (!parseNumber(value, suffix))
+                    return RangeResult::Full;
+                if (suffix != 0 && size != 0)
+                {
+                    first = suffix >= size ? 0 : size - suffix;
+                    ranges.push_back({first, size - first});
+                }
+            }
+            else
+            {
+                if (!parseNumber(value, first) || value.empty() || value.front() != '-')
+                    return RangeResult::Full;
+                value.remove_prefix(1);
+
+                auto open = value.empty() || value.front() == ',' || value.front() == ' ' || value.front() == '\t';
+                if (open)
+                    last = size == 0 ? 0 : size - 1;
+                else if (!parseNumber(value, last) || last < first)
+                    return RangeResult::Full;
+
+                if (first < size)
+                {
+                    last = last >= size ? size - 1 : last;
+                    ranges.push_back({first, last - first + 1});
+                }
+            }
+
+            skipWhitespace(value);
+            if (!value.empty() && value.front() != ',')
+                return RangeResult::Full;
+        }
+
+        if (specifiers == 0)
+            return RangeResult::Full;
+        return ranges.empty() ? RangeResult::Unsatisfiable : RangeResult::Partial;
+    }
+//#######################################################################################################
+} // namespace Rest
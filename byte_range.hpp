@@ -0,0 +1,43 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  A part of a representation, resolved against its size.
+     */
+    struct ByteRange
+    {
+        std::uint64_t first;
+        std::uint64_t length;
+    };
+
+    enum class RangeResult
+    {
+        Full, // no usable Range field, send the whole representation.
+        Partial, // send the ranges with 206 (Partial Content).
+        Unsatisfiable // no range overlaps the representation, answer with 416.
+    };
+
+    /**
+     *  The most ranges served in one response. Requests for more get the whole representation.
+     */
+    constexpr std::size_t maxByteRanges = 16;
+
+    /**
+     *  Parses the value of a Range field (RFC 7233), like "bytes=0-499", "bytes=500-" or "bytes=-500".
+     *  Ranges are kept in the requested order, their ends are clamped to the size.
+     *  Fields with another unit or broken syntax are ignored, as the RFC demands.
+     *
+     *  @param value The field value.
+     *  @param size The size of the representation.
+     *  @param ranges Receives the satisfiable ranges.
+     */
+    RangeResult parseByteRanges(boost::string_view value, std::uint64_t size, std::vector <ByteRange>& ranges);
+
+} // namespace Rest
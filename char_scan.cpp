@@ -0,0 +1,205 @@
+#include "char_scan.hpp"
+
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define SREST_SCAN_X86
+#   include <immintrin.h>
+#endif
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        using Scanner = char const* (*)(char const*, char const*);
+
+        /**
+         *  Which characters each scanner skips.
+         */
+        struct CharTables
+        {
+            bool token[256];
+            bool target[256];
+            bool fieldValue[256];
+
+            CharTables()
+            {
+                for (int i = 0; i != 256; ++i)
+                {
+                    auto c = static_cast <unsigned char> (i);
+                    token[i] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                               (c != 0 && std::strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+                    target[i] = c > 0x20 && c != 0x7F;
+                    fieldValue[i] = (c >= 0x20 && c != 0x7F) || c == '\t';
+                }
+            }
+        };
+
+        CharTables const& tables()
+        {
+            static CharTables const charTables;
+            return charTables;
+        }
+
+        char const* scanScalar(char const* begin, char const* end, bool const* allowed)
+        {
+            while (begin != end && allowed[static_cast <unsigned char> (*begin)])
+                ++begin;
+            return begin;
+        }
+
+        char const* tokenScalar(char const* begin, char const* end)
+        {
+            return scanScalar(begin, end, tables().token);
+        }
+
+        char const* targetScalar(char const* begin, char const* end)
+        {
+            return scanScalar(begin, end, tables().target);
+        }
+
+        char const* fieldValueScalar(char const* begin, char const* end)
+        {
+            return scanScalar(begin, end, tables().fieldValue);
+        }
+
+#ifdef SREST_SCAN_X86
+        /**
+         *  Finds the first character within one of the ranges, 16 bytes at a time (pcmpestri).
+         *  The ranges may be wider than necessary, hits are verified with the table.
+         */
+        __attribute__((target("sse4.2")))
+        char const* scanRanges(char const* begin, char const* end, char const* ranges, int rangesSize, bool const* allowed)
+        {
+            __m128i const rangeVector = _mm_loadu_si128(reinterpret_cast <__m128i const*> (ranges));
+            while (end - begin >= 16)
+            {
+                __m128i const chunk = _mm_loadu_si128(reinterpret_cast <__m128i const*> (begin));
+                int index = _mm_cmpestri(rangeVector, rangesSize, chunk, 16, _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+                if (index == 16)
+                {
+                    begin += 16;
+                    continue;
+                }
+
+                begin += index;
+                if (!allowed[static_cast <unsigned char> (*begin)])
+                    return begin;
+                ++begin; // false positive
+            }
+            return scanScalar(begin, end, allowed);
+        }
+
+        __attribute__((target("sse4.2")))
+        char const* tokenSse42(char const* begin, char const* end)
+        {
+            // 16 bytes is all pcmpestri takes, so '|', '}' and '~' are caught by the last range too.
+            static char const ranges[16] = {
+                '\x00', ' ', '"', '"', '(', ')', ',', ',', '/', '/', ':', '@', '[', ']', '{', '\xFF'
+            };
+            return scanRanges(begin, end, ranges, 16, tables().token);
+        }
+
+        __attribute__((target("sse4.2")))
+        char const* targetSse42(char const* begin, char const* end)
+        {
+            static char const ranges[16] = {'\x00', ' ', '\x7F', '\x7F'};
+            return scanRanges(begin, end, ranges, 4, tables().target);
+        }
+
+        __attribute__((target("sse4.2")))
+        char const* fieldValueSse42(char const* begin, char const* end)
+        {
+            static char const ranges[16] = {'\x00', '\x08', '\x0A', '\x1F', '\x7F', '\x7F'};
+            return scanRanges(begin, end, ranges, 6, tables().fieldValue);
+        }
+
+        /**
+         *  Finds the first control character (<= upper, or DEL), 32 bytes at a time.
+         */
+        __attribute__((target("avx2")))
+        char const* scanControlAvx2(char const* begin, char const* end, char upper, bool allowTab, bool const* allowed)
+        {
+            __m256i const upperVector = _mm256_set1_epi8(upper);
+            __m256i const deleteVector = _mm256_set1_epi8('\x7F');
+            __m256i const tabVector = _mm256_set1_epi8('\t');
+            while (end - begin >= 32)
+            {
+                __m256i const chunk = _mm256_loadu_si256(reinterpret_cast <__m256i const*> (begin));
+
+                // unsigned chunk <= upper
+                __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, upperVector), chunk);
+                if (allowTab)
+                    control = _mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tabVector), control);
+                control = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, deleteVector));
+
+                auto mask = static_cast <unsigned> (_mm256_movemask_epi8(control));
+                if (mask != 0)
+                    return begin + __builtin_ctz(mask);
+                begin += 32;
+            }
+            return scanScalar(begin, end, allowed);
+        }
+
+        __attribute__((target("avx2")))
+        char const* targetAvx2(char const* begin, char const* end)
+        {
+            return scanControlAvx2(begin, end, ' ', false, tables().target);
+        }
+
+        __attribute__((target("avx2")))
+        char const* fieldValueAvx2(char const* begin, char const* end)
+        {
+            return scanControlAvx2(begin, end, '\x1F', true, tables().fieldValue);
+        }
+#endif // SREST_SCAN_X86
+
+        struct Kernels
+        {
+            char const* name;
+            Scanner token;
+            Scanner target;
+            Scanner fieldValue;
+        };
+
+        Kernels selectKernels()
+        {
+#ifdef SREST_SCAN_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return {"avx2", tokenSse42, targetAvx2, fieldValueAvx2};
+            if (__builtin_cpu_supports("sse4.2"))
+                return {"sse4.2", tokenSse42, targetSse42, fieldValueSse42};
+#endif
+            return {"scalar", tokenScalar, targetScalar, fieldValueScalar};
+        }
+
+        Kernels const& kernels()
+        {
+            static Kernels const selected = selectKernels();
+            return selected;
+        }
+    }
+//#######################################################################################################
+    char const* scanToken(char const* begin, char const* end)
+    {
+        return kernels().token(begin, end);
+    }
+//-------------------------------------------------------------------------------------------------------
+    char const* scanTarget(char const* begin, char const* end)
+    {
+        return kernels().target(begin, end);
+    }
+//-------------------------------------------------------------------------------------------------------
+    char const* scanFieldValue(char const* begin, char const* end)
+    {
+        return kernels().fieldValue(begin, end);
+    }
+//-------------------------------------------------------------------------------------------------------
+    char const* getScanKernelName()
+    {
+        return kernels().name;
+    }
+//#######################################################################################################
+} // namespace Rest
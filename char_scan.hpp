@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Rest {
+
+    /*
+     *  Scanners used by the RequestParser to skip over runs of valid characters.
+     *  Each returns the first character in [begin, end) that ends the run, or end.
+     *
+     *  On x86 with GCC or Clang SSE4.2 or AVX2 kernels are picked at runtime, depending on the CPU.
+     *  Everything else uses a scalar loop.
+     */
+
+    /**
+     *  Skips token characters (tchar, RFC 7230). Stops at ' ', ':', control characters, etc.
+     */
+    char const* scanToken(char const* begin, char const* end);
+
+    /**
+     *  Skips characters allowed in a request target. Stops at ' ', CR, LF and other control characters.
+     */
+    char const* scanTarget(char const* begin, char const* end);
+
+    /**
+     *  Skips characters allowed in a header field value, including spaces and tabs.
+     *  Stops at CR, LF and other control characters.
+     */
+    char const* scanFieldValue(char const* begin, char const* end);
+
+    /**
+     *  Returns the name of the kernel set in use: "avx2", "sse4.2" or "scalar".
+     */
+    char const* getScanKernelName();
+
+} // namespace Rest
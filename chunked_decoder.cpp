@@ -0,0 +1,253 @@
+#include "chunked_decoder.hpp"
+
+#include <boost/algorithm/string/trim.hpp>
+
+#include <algorithm>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        int hexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+    }
+//#######################################################################################################
+    ChunkedDecoder::ChunkedDecoder(std::size_t maxBodySize, std::size_t maxTrailerSize, std::size_t maxExtensionSize)
+        : maxBodySize_(maxBodySize)
+        , maxTrailerSize_(maxTrailerSize)
+        , maxExtensionSize_(maxExtensionSize)
+        , state_(State::SizeStart)
+        , chunkRemaining_(0)
+        , sizeDigits_(0)
+        , extensionSize_(0)
+        , bodySize_(0)
+        , trailerSize_(0)
+        , line_()
+        , trailers_()
+        , tooLarge_(false)
+        , error_("")
+    {
+
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ChunkedDecoder::reset()
+    {
+        state_ = State::SizeStart;
+        chunkRemaining_ = 0;
+        sizeDigits_ = 0;
+        extensionSize_ = 0;
+        bodySize_ = 0;
+        trailerSize_ = 0;
+        line_.clear();
+        trailers_.clear();
+        tooLarge_ = false;
+        error_ = "";
+    }
+//-------------------------------------------------------------------------------------------------------
+    ChunkedDecoder::Result ChunkedDecoder::fail(char const* error)
+    {
+        state_ = State::Failed;
+        error_ = error;
+        return Result::Error;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool ChunkedDecoder::addTrailer()
+    {
+        auto colon = line_.find(':');
+        if (colon == std::string::npos || colon == 0)
+            return false;
+
+        auto name = line_.substr(0, colon);
+        auto value = line_.substr(colon + 1);
+        boost::algorithm::trim_if(value, [](char c) { return c == ' ' || c == '\t'; });
+        trailers_.emplace_back(std::move(name), std::move(value));
+        line_.clear();
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    ChunkedDecoder::Result ChunkedDecoder::decode(char const* data, std::size_t size, std::size_t& consumed, boost::string_view& chunk)
+    {
+        consumed = 0;
+        if (state_ == State::Complete)
+            return Result::Complete;
+        if (state_ == State::Failed)
+            return Result::Error;
+
+        while (consumed < size)
+        {
+            auto c = data[consumed];
+            switch (state_)
+            {
+                case (State::SizeStart):
+                case (State::Size):
+                {
+                    auto digit = hexValue(c);
+                    if (digit >= 0)
+                    {
+                        // leading zeros do not count, everything else must fit.
+                        if (chunkRemaining_ != 0 && ++sizeDigits_ > 15)
+                            return fail("Chunk size is too large.");
+                        chunkRemaining_ = chunkRemaining_ * 16 + static_cast <std::uint64_t> (digit);
+                        state_ = State::Size;
+                        ++consumed;
+                        break;
+                    }
+                    if (state_ == State::SizeStart)
+                        return fail("Chunk size is missing.");
+                    if (c == ';' || c == ' ' || c == '\t')
+                        state_ = State::Extension;
+                    else if (c == '\r')
+                        state_ = State::SizeLineEnd;
+                    else if (c == '\n')
+                        state_ = chunkRemaining_ == 0 ? State::TrailerStart : State::Data;
+                    else
+                        return fail("Invalid character in chunk size.");
+                    ++consumed;
+                    break;
+                }
+                case (State::Extension):
+                {
+                    if (++extensionSize_ > maxExtensionSize_)
+                        return fail("Chunk extension is too large.");
+                    if (c == '\r')
+                        state_ = State::SizeLineEnd;
+                    else if (c == '\n')
+                        state_ = chunkRemaining_ == 0 ? State::TrailerStart : State::Data;
+                    ++consumed;
+                    break;
+                }
+                case (State::SizeLineEnd):
+                {
+                    if (c != '\n')
+                        return fail("Carriage return without line feed.");
+                    state_ = chunkRemaining_ == 0 ? State::TrailerStart : State::Data;
+                    ++consumed;
+                    break;
+                }
+                case (State::Data):
+                {
+                    if (chunkRemaining_ > maxBodySize_ - bodySize_)
+                    {
+                        tooLarge_ = true;
+                        return fail("Request body is too large.");
+                    }
+
+                    auto amount = static_cast <std::size_t> (std::min(chunkRemaining_, static_cast <std::uint64_t> (size - consumed)));
+                    chunk = {data + consumed, amount};
+                    consumed += amount;
+                    chunkRemaining_ -= amount;
+                    bodySize_ += amount;
+                    if (chunkRemaining_ == 0)
+                        state_ = State::DataEnd;
+                    return Result::Data;
+                }
+                case (State::DataEnd):
+                {
+                    if (c == '\r')
+                        state_ = State::DataLineEnd;
+                    else if (c == '\n')
+                        state_ = State::SizeStart;
+                    else
+                        return fail("Chunk is longer than announced.");
+                    sizeDigits_ = 0;
+                    extensionSize_ = 0;
+                    ++consumed;
+                    break;
+                }
+                case (State::DataLineEnd):
+                {
+                    if (c != '\n')
+                        return fail("Carriage return without line feed.");
+                    state_ = State::SizeStart;
+                    ++consumed;
+                    break;
+                }
+                case (State::TrailerStart):
+                {
+                    if (c == '\r')
+                    {
+                        state_ = State::FinalLineEnd;
+                        ++consumed;
+                        break;
+                    }
+                    if (c == '\n')
+                    {
+                        state_ = State::Complete;
+                        ++consumed;
+                        return Result::Complete;
+                    }
+                    state_ = State::TrailerLine;
+                    break;
+                }
+                case (State::TrailerLine):
+                {
+                    if (c == '\r' || c == '\n')
+                    {
+                        if (!addTrailer())
+                            return fail("Invalid trailer field.");
+                        state_ = c == '\r' ? State::TrailerLineEnd : State::TrailerStart;
+                    }
+                    else
+                    {
+                        if (++trailerSize_ > maxTrailerSize_)
+                            return fail("Trailer is too large.");
+                        line_.push_back(c);
+                    }
+                    ++consumed;
+                    break;
+                }
+                case (State::TrailerLineEnd):
+                {
+                    if (c != '\n')
+                        return fail("Carriage return without line feed.");
+                    state_ = State::TrailerStart;
+                    ++consumed;
+                    break;
+                }
+                case (State::FinalLineEnd):
+                {
+                    if (c != '\n')
+                        return fail("Carriage return without line feed.");
+                    state_ = State::Complete;
+                    ++consumed;
+                    return Result::Complete;
+                }
+                case (State::Complete):
+                    return Result::Complete;
+                case (State::Failed):
+                    return Result::Error;
+            }
+        }
+        return Result::NeedMore;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t ChunkedDecoder::getBodySize() const
+    {
+        return bodySize_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::vector <ChunkedDecoder::Trailer> const& ChunkedDecoder::getTrailers() const
+    {
+        return trailers_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool ChunkedDecoder::isTooLarge() const
+    {
+        return tooLarge_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    char const* ChunkedDecoder::getError() const
+    {
+        return error_;
+    }
+//#######################################################################################################
+} // namespace Rest
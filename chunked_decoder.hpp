@@ -0,0 +1,121 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace Rest {
+
+    /**
+     *  An incremental decoder for "Transfer-Encoding: chunked" bodies (RFC 7230 4.1).
+     *  It keeps no copy of the input: Framing is parsed byte by byte and chunk data is handed out
+     *  as views into the buffer passed to decode, so any amount of input can be fed at a time.
+     */
+    class ChunkedDecoder
+    {
+    public:
+        enum class Result
+        {
+            Data, // chunk is set to a piece of the body.
+            NeedMore, // all input was framing, or ended in the middle of it.
+            Complete, // the last chunk and the trailer have been read.
+            Error
+        };
+
+        using Trailer = std::pair <std::string, std::string>;
+
+        /**
+         *  @param maxBodySize Decoded bodies larger than this are an error.
+         *  @param maxTrailerSize Maximum size of all trailer fields together.
+         *  @param maxExtensionSize Maximum size of the chunk extensions of a single size line. They are ignored.
+         */
+        ChunkedDecoder(std::size_t maxBodySize = std::numeric_limits <std::size_t>::max(),
+                       std::size_t maxTrailerSize = 8192,
+                       std::size_t maxExtensionSize = 1024);
+
+        /**
+         *  Continues decoding.
+         *
+         *  @param data Input that follows whatever was passed before.
+         *  @param size Size of the input.
+         *  @param consumed Set to the amount of input that has been used, including the returned chunk.
+         *                  The rest must be passed again on the next call. After Complete the rest
+         *                  does not belong to the body.
+         *  @param chunk Set to a part of data, if the result is Data.
+         */
+        Result decode(char const* data, std::size_t size, std::size_t& consumed, boost::string_view& chunk);
+
+        /**
+         *  Prepares the decoder for the next body.
+         */
+        void reset();
+
+        /**
+         *  Returns the amount of body bytes decoded so far.
+         */
+        std::size_t getBodySize() const;
+
+        /**
+         *  Returns the trailer fields, once decode returned Complete.
+         */
+        std::vector <Trailer> const& getTrailers() const;
+
+        /**
+         *  Returns whether decoding failed because the body is too large.
+         */
+        bool isTooLarge() const;
+
+        /**
+         *  Returns a description of what went wrong, if decode returned Error.
+         */
+        char const* getError() const;
+
+    private:
+        enum class State
+        {
+            SizeStart,
+            Size,
+            Extension,
+            SizeLineEnd,
+            Data,
+            DataEnd,
+            DataLineEnd,
+            TrailerStart,
+            TrailerLine,
+            TrailerLineEnd,
+            FinalLineEnd,
+            Complete,
+            Failed
+        };
+
+        Result fail(char const* error);
+
+        /**
+         *  Stores the trailer field in line_.
+         */
+        bool addTrailer();
+
+    private:
+        std::size_t maxBodySize_;
+        std::size_t maxTrailerSize_;
+        std::size_t maxExtensionSize_;
+
+        State state_;
+        std::uint64_t chunkRemaining_; // size of the current chunk, then its unread bytes.
+        std::size_t sizeDigits_;
+        std::size_t extensionSize_;
+        std::size_t bodySize_;
+        std::size_t trailerSize_;
+        std::string line_; // the trailer line currently parsed.
+        std::vector <Trailer> trailers_;
+        bool tooLarge_;
+
+        char const* error_;
+    };
+
+} // namespace Rest
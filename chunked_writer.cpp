@@ -0,0 +1,130 @@
+#include "chunked_writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Rest
+{
+//#######################################################################################################
+    ChunkBuffer::ChunkBuffer(std::ostream& sink, std::function <void()> push, std::size_t coalesceSize, bool chunked, bool discard)
+        : buffer_(std::max(coalesceSize, static_cast <std::size_t> (64u)))
+        , sink_(sink)
+        , push_(std::move(push))
+        , chunked_(chunked)
+        , discard_(discard)
+        , finished_(false)
+    {
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ChunkBuffer::writeChunk(char const* data, std::size_t size)
+    {
+        if (discard_ || finished_ || size == 0)
+            return;
+        if (!chunked_)
+        {
+            sink_.write(data, static_cast <std::streamsize> (size));
+            return;
+        }
+
+        // chunk-size in hex, then CRLF.
+        char line[2 * sizeof(std::size_t) + 2];
+        auto end = line + sizeof(line);
+        auto begin = end;
+        *--begin = '\n';
+        *--begin = '\r';
+        auto remaining = size;
+        do {
+            *--begin = "0123456789abcdef"[remaining & 0xF];
+            remaining >>= 4;
+        } while (remaining != 0);
+
+        sink_.write(begin, end - begin);
+        sink_.write(data, static_cast <std::streamsize> (size));
+        sink_.write("\r\n", 2);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ChunkBuffer::emit()
+    {
+        writeChunk(pbase(), static_cast <std::size_t> (pptr() - pbase()));
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ChunkBuffer::finish()
+    {
+        if (finished_)
+            return;
+
+        emit();
+        if (chunked_ && !discard_)
+            sink_.write("0\r\n\r\n", 5);
+        finished_ = true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool ChunkBuffer::isFinished() const
+    {
+        return finished_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    ChunkBuffer::int_type ChunkBuffer::overflow(int_type ch)
+    {
+        emit();
+        push_();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::streamsize ChunkBuffer::xsputn(char_type const* data, std::streamsize count)
+    {
+        auto amount = static_cast <std::size_t> (count);
+        auto pending = static_cast <std::size_t> (pptr() - pbase());
+        if (pending + amount <= buffer_.size())
+        {
+            std::memcpy(pptr(), data, amount);
+            pbump(static_cast <int> (amount));
+            return count;
+        }
+
+        // a full chunk is ready.
+        emit();
+        if (amount >= buffer_.size())
+            writeChunk(data, amount); // large pieces become a chunk of their own, without copying them first.
+        else
+        {
+            std::memcpy(pptr(), data, amount);
+            pbump(static_cast <int> (amount));
+        }
+        push_();
+        return count;
+    }
+//-------------------------------------------------------------------------------------------------------
+    int ChunkBuffer::sync()
+    {
+        emit();
+        push_();
+        return 0;
+    }
+//#######################################################################################################
+    ChunkedWriter::ChunkedWriter(std::ostream& sink, std::function <void()> push, std::size_t coalesceSize, bool chunked, bool discard)
+        : std::ostream(nullptr)
+        , buffer_(sink, std::move(push), coalesceSize, chunked, discard)
+    {
+        rdbuf(&buffer_);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ChunkedWriter::end()
+    {
+        buffer_.finish();
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool ChunkedWriter::isEnded() const
+    {
+        return buffer_.isFinished();
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  The stream buffer behind a ChunkedWriter.
+     *  Collects written data up to the coalescing size, then emits it as a single chunk
+     *  into the connection stream and pushes it to the socket.
+     */
+    class ChunkBuffer : public std::streambuf
+    {
+    public:
+        /**
+         *  @param sink The connection stream the chunks are written to.
+         *  @param push Passes everything written to sink to the socket.
+         *  @param coalesceSize Data is collected until this many bytes are pending.
+         *  @param chunked Use chunked framing. Otherwise the data is written as is (HTTP/1.0 clients).
+         *  @param discard Drop everything, the response must not have a body (HEAD requests).
+         */
+        ChunkBuffer(std::ostream& sink, std::function <void()> push, std::size_t coalesceSize, bool chunked, bool discard);
+
+        /**
+         *  Emits the pending data and the last chunk. Everything written afterwards is dropped.
+         */
+        void finish();
+
+        /**
+         *  Returns whether finish has been called.
+         */
+        bool isFinished() const;
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(char_type const* data, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        /**
+         *  Writes the pending data as one chunk.
+         */
+        void emit();
+
+        void writeChunk(char const* data, std::size_t size);
+
+    private:
+        std::vector <char> buffer_;
+        std::ostream& sink_;
+        std::function <void()> push_;
+        bool chunked_;
+        bool discard_;
+        bool finished_;
+    };
+
+    /**
+     *  A stream for responses whose length is not known up front, see Response::stream.
+     *  Sends the body with "Transfer-Encoding: chunked", piece by piece as it is written.
+     *  Calling flush sends everything written so far immediately.
+     */
+    class ChunkedWriter : public std::ostream
+    {
+    public:
+        ChunkedWriter(std::ostream& sink, std::function <void()> push, std::size_t coalesceSize, bool chunked, bool discard);
+
+        ChunkedWriter(ChunkedWriter const&) = delete;
+        ChunkedWriter& operator=(ChunkedWriter const&) = delete;
+
+        /**
+         *  Sends the rest and terminates the body.
+         *  Called automatically when the handler returns.
+         */
+        void end();
+
+        /**
+         *  Returns whether the body has been terminated.
+         */
+        bool isEnded() const;
+
+    private:
+        ChunkBuffer buffer_;
+    };
+
+} // namespace Rest
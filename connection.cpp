@@ -1,42 +1,170 @@
 #include "connection.hpp"
+#include "response_code.hpp"
+#include "http_date.hpp"
+#include "byte_range.hpp"
+#include "entity_tag.hpp"
 #include "server.hpp"
 #include "mime.hpp"
 
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <array>
 #include <fstream>
 #include <stdexcept>
 #include <iterator>
 #include <algorithm>
 
 #include <iostream>
+#include <limits>
+#include <random>
+
+#ifndef _WIN32
+#   include <poll.h>
+#   include <cerrno>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#ifdef __linux__
+#   include <sys/sendfile.h>
+#   include <signal.h>
+#   include <pthread.h>
+#endif
 
 namespace Rest
 {
 //#######################################################################################################
-    std::string extractFileExtension(std::string const& fileName)
-    {
-        std::string extension;
-        auto slpos = fileName.rfind("/");
-        if (slpos == std::string::npos)
-            slpos = fileName.rfind("\\");
-        if (slpos != std::string::npos)
-            extension = fileName.substr(slpos, extension.length() - slpos);
-        else
-            return "";
+#ifdef __linux__
+    namespace
+    {
+        /**
+         *  Closes a file descriptor when leaving the scope.
+         */
+        class FileHandle
+        {
+        public:
+            explicit FileHandle(int descriptor)
+                : descriptor_(descriptor)
+            {
+            }
 
-        auto dotpos = extension.find(".");
-        if (dotpos == std::string::npos)
-            return "";
-        else
-            return extension.substr(dotpos, extension.length() - dotpos);
+            ~FileHandle()
+            {
+                if (descriptor_ >= 0)
+                    ::close(descriptor_);
+            }
+
+            FileHandle(FileHandle const&) = delete;
+            FileHandle& operator=(FileHandle const&) = delete;
+
+            int get() const
+            {
+                return descriptor_;
+            }
+
+        private:
+            int descriptor_;
+        };
+
+        /**
+         *  Unlike send, sendfile cannot be told not to raise SIGPIPE when the client has gone away.
+         *  Blocks the signal for the current thread and discards it if it was raised meanwhile.
+         */
+        class PipeSignalBlock
+        {
+        public:
+            PipeSignalBlock()
+            {
+                sigemptyset(&pipe_);
+                sigaddset(&pipe_, SIGPIPE);
+
+                sigset_t pending;
+                sigpending(&pending);
+                wasPending_ = sigismember(&pending, SIGPIPE) == 1;
+                pthread_sigmask(SIG_BLOCK, &pipe_, &previous_);
+            }
+
+            ~PipeSignalBlock()
+            {
+                if (!wasPending_)
+                {
+                    timespec noWait = {0, 0};
+                    while (sigtimedwait(&pipe_, nullptr, &noWait) == SIGPIPE)
+                        ;
+                }
+                pthread_sigmask(SIG_SETMASK, &previous_, nullptr);
+            }
+
+            PipeSignalBlock(PipeSignalBlock const&) = delete;
+            PipeSignalBlock& operator=(PipeSignalBlock const&) = delete;
+
+        private:
+            sigset_t pipe_;
+            sigset_t previous_;
+            bool wasPending_;
+        };
+    }
+#endif
+//#######################################################################################################
+    namespace
+    {
+        std::size_t parseContentLength(boost::string_view value)
+        {
+            if (value.empty())
+                throw InvalidRequest("Content-Length is not a number.");
+
+            std::size_t length = 0;
+            for (auto c : value)
+            {
+                if (c < '0' || c > '9')
+                    throw InvalidRequest("Content-Length is not a number.");
+                if (length > (std::numeric_limits <std::size_t>::max() - 9) / 10)
+                    throw InvalidRequest("Content-Length is too large.");
+                length = length * 10 + static_cast <std::size_t> (c - '0');
+            }
+            return length;
+        }
     }
 //#######################################################################################################
-    RestConnection::RestConnection(RestServer* owner, UserId const& id)
+    RestConnection::RestConnection(RestServer* owner, UserId const& id, boost::asio::io_service& service, std::size_t shard)
         : owner_(owner)
         , id_(id)
-        , stream_()
+        , socket_(service)
+        , strand_(service)
+        , input_(owner->settings_.maxHeaderSize + owner->settings_.asyncBodyLimit)
+        , output_([this](char const* data, std::size_t size) { write(data, size); })
+        , stream_(&output_)
+        , body_()
+        , bodyBuffer_(body_)
+        , bodyStream_(&bodyBuffer_)
+        , commonFields_()
         , endpoint_()
+        , shard_(shard)
+        , asynchronous_(owner->settings_.mode != ServerMode::Threaded)
+        , timer_(service)
+        , waitingForHead_(false)
+        , headReadable_(false)
+        , headTimedOut_(false)
+        , headDeadline_(std::chrono::steady_clock::now() + owner->settings_.idleTimeout)
+        , waitingForBody_(false)
+        , waitingForWrite_(false)
+        , fileParts_()
+        , copyBuffer_()
+        , keepAlive_(false)
+        , responded_(false)
+        , requestCount_(0)
+        , pipelined_(0)
+        , parser_(owner->settings_.maxHeaderSize)
+        , bodyRemaining_(0)
+        , chunkSize_(0)
+        , chunked_(false)
+        , decoder_(owner->settings_.maxBodySize, owner->settings_.maxHeaderSize)
+        , head_()
         , request_()
+        , chunkedWriter_()
     {
+        output_.setDeferred(asynchronous_);
     }
 //-------------------------------------------------------------------------------------------------------
     void RestConnection::free()
@@ -44,7 +172,496 @@ namespace Rest
         owner_->deregisterClient(this);
     }
 //-------------------------------------------------------------------------------------------------------
-    boost::asio::ip::tcp::iostream& RestConnection::getStream()
+    void RestConnection::write(char const* data, std::size_t size)
+    {
+        boost::system::error_code ec;
+        boost::asio::write(socket_, boost::asio::buffer(data, size), ec);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::close()
+    {
+        auto self = shared_from_this();
+        strand_.post([this, self]() {
+            boost::system::error_code ec;
+            timer_.cancel(ec);
+            socket_.close(ec);
+        });
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::closeIfWaiting()
+    {
+        auto self = shared_from_this();
+        strand_.post([this, self]() {
+            if (!waitingForHead_)
+                return;
+            boost::system::error_code ec;
+            timer_.cancel(ec);
+            socket_.close(ec);
+        });
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::waitReadable(std::chrono::milliseconds timeout)
+    {
+        if (timeout.count() < 0)
+            return false;
+#ifdef _WIN32
+        WSAPOLLFD descriptor = {};
+        descriptor.fd = socket_.native_handle();
+        descriptor.events = POLLRDNORM;
+        return WSAPoll(&descriptor, 1, static_cast <INT> (timeout.count())) > 0;
+#else
+        pollfd descriptor = {};
+        descriptor.fd = socket_.native_handle();
+        descriptor.events = POLLIN;
+        int result;
+        do {
+            result = ::poll(&descriptor, 1, static_cast <int> (timeout.count()));
+        } while (result < 0 && errno == EINTR);
+        return result > 0;
+#endif
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::waitWritable(std::chrono::milliseconds timeout)
+    {
+        if (timeout.count() < 0)
+            return false;
+#ifdef _WIN32
+        WSAPOLLFD descriptor = {};
+        descriptor.fd = socket_.native_handle();
+        descriptor.events = POLLWRNORM;
+        return WSAPoll(&descriptor, 1, static_cast <INT> (timeout.count())) > 0;
+#else
+        pollfd descriptor = {};
+        descriptor.fd = socket_.native_handle();
+        descriptor.events = POLLOUT;
+        int result;
+        do {
+            result = ::poll(&descriptor, 1, static_cast <int> (timeout.count()));
+        } while (result < 0 && errno == EINTR);
+        return result > 0;
+#endif
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::start()
+    {
+        readHeadAsync();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::readHeadAsync()
+    {
+        if (hasBufferedHead())
+        {
+            processHead();
+            return;
+        }
+
+        auto self = shared_from_this();
+
+        // an idle connection is closed, the read below then completes with an error.
+        waitingForHead_ = true;
+        timer_.expires_from_now(owner_->settings_.idleTimeout);
+        timer_.async_wait(strand_.wrap(
+            [this, self](boost::system::error_code const& ec)
+            {
+                if (ec || !waitingForHead_)
+                    return;
+                boost::system::error_code ignore;
+                socket_.close(ignore);
+            }
+        ));
+
+        receiveHeadAsync();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::receiveHeadAsync()
+    {
+        auto self = shared_from_this();
+        auto space = owner_->settings_.maxHeaderSize - std::min(input_.size(), owner_->settings_.maxHeaderSize);
+        socket_.async_read_some(input_.prepare(std::min(static_cast <std::size_t> (4096u), space)), strand_.wrap(
+            [this, self](boost::system::error_code const& ec, std::size_t amount)
+            {
+                if (ec)
+                {
+                    boost::system::error_code ignore;
+                    timer_.cancel(ignore);
+                    free();
+                    return;
+                }
+
+                input_.commit(amount);
+                if (!hasBufferedHead())
+                {
+                    receiveHeadAsync();
+                    return;
+                }
+
+                waitingForHead_ = false;
+                boost::system::error_code ignore;
+                timer_.cancel(ignore);
+                processHead();
+            }
+        ));
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::processHead()
+    {
+        try {
+            parseHead();
+        } catch (InvalidRequest const& exc) {
+            owner_->handleError(shared_from_this(), exc);
+            finish();
+            return;
+        }
+        readBodyAsync();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::readBodyAsync()
+    {
+        auto self = shared_from_this();
+        if (bodyRemaining_ > input_.size() && bodyRemaining_ <= owner_->settings_.asyncBodyLimit)
+        {
+            // a stalled upload cancels the read below.
+            waitingForBody_ = true;
+            timer_.expires_from_now(owner_->settings_.bodyTimeout);
+            timer_.async_wait(strand_.wrap(
+                [this, self](boost::system::error_code const& ec)
+                {
+                    if (ec || !waitingForBody_)
+                        return;
+                    boost::system::error_code ignore;
+                    socket_.cancel(ignore);
+                }
+            ));
+
+            boost::asio::async_read(socket_, input_, boost::asio::transfer_exactly(bodyRemaining_ - input_.size()), strand_.wrap(
+                [this, self](boost::system::error_code const& ec, std::size_t)
+                {
+                    waitingForBody_ = false;
+                    boost::system::error_code ignore;
+                    timer_.cancel(ignore);
+
+                    if (ec)
+                    {
+                        // the rest of the connection is out of sync, answer and close.
+                        keepAlive_ = false;
+                        bodyRemaining_ = 0;
+                        if (ec == boost::asio::error::operation_aborted)
+                            owner_->handleError(self, RequestTimeout("Timeout while reading the request body."));
+                        else
+                            owner_->handleError(self, InvalidRequest("The request body is incomplete."));
+                        finish();
+                        return;
+                    }
+                    owner_->handle(self);
+                    finish();
+                }
+            ));
+            return;
+        }
+
+        owner_->handle(self);
+        finish();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::finish()
+    {
+        auto self = shared_from_this();
+        auto next = prepareNext();
+
+        // the next pipelined request is here already, its response is written together with this one.
+        // Not behind queued file parts, the next handler might write to the socket itself with sendChunked.
+        if (next && hasBufferedHead() && fileParts_.empty() && ++pipelined_ < owner_->settings_.maxPipelinedRequests)
+        {
+            strand_.post([this, self]() { processHead(); });
+            return;
+        }
+        pipelined_ = 0;
+        writeAsync(0, 0, next);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::writeAsync(std::size_t written, std::size_t part, bool next)
+    {
+        auto self = shared_from_this();
+
+        // everything up to the next part that is sent from a descriptor.
+        std::vector <boost::asio::const_buffer> buffers;
+        for (; part != fileParts_.size(); ++part)
+        {
+            auto const& file = fileParts_[part];
+            buffers.push_back(boost::asio::buffer(output_.data() + written, file.position - written));
+            written = file.position;
+            if (!file.contents)
+                break;
+            buffers.push_back(boost::asio::buffer(file.contents + file.offset, static_cast <std::size_t> (file.length)));
+        }
+        if (part == fileParts_.size())
+        {
+            buffers.push_back(boost::asio::buffer(output_.data() + written, output_.size() - written));
+            written = output_.size();
+        }
+
+        boost::asio::async_write(socket_, buffers, strand_.wrap(
+            [this, self, written, part, next](boost::system::error_code const& ec, std::size_t)
+            {
+                if (ec || part == fileParts_.size())
+                {
+                    finishWrite(ec, next);
+                    return;
+                }
+#ifdef __linux__
+                sendFilePartAsync(written, part, next);
+#endif
+            }
+        ));
+    }
+//-------------------------------------------------------------------------------------------------------
+#ifdef __linux__
+    void RestConnection::sendFilePartAsync(std::size_t written, std::size_t part, bool next)
+    {
+        auto& file = fileParts_[part];
+        PipeSignalBlock noPipeSignal;
+        boost::system::error_code ignore;
+        socket_.native_non_blocking(true, ignore);
+        while (file.length != 0)
+        {
+            auto position = static_cast <off_t> (file.offset);
+            auto amount = static_cast <std::size_t> (std::min <std::uint64_t> (file.length, 1u << 30));
+            auto sent = ::sendfile(socket_.native_handle(), file.descriptor, &position, amount);
+            if (sent > 0)
+            {
+                file.offset += static_cast <std::uint64_t> (sent);
+                file.length -= static_cast <std::uint64_t> (sent);
+                continue;
+            }
+
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent < 0 && (errno == EINVAL || errno == ENOSYS))
+            {
+                copyFilePartAsync(written, part, next);
+                return;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // a client that stops reading is given up on like an idle one.
+                auto self = shared_from_this();
+                waitingForWrite_ = true;
+                timer_.expires_from_now(owner_->settings_.idleTimeout);
+                timer_.async_wait(strand_.wrap(
+                    [this, self](boost::system::error_code const& ec)
+                    {
+                        if (ec || !waitingForWrite_)
+                            return;
+                        boost::system::error_code ignore;
+                        socket_.cancel(ignore);
+                    }
+                ));
+                socket_.async_wait(boost::asio::ip::tcp::socket::wait_write, strand_.wrap(
+                    [this, self, written, part, next](boost::system::error_code const& ec)
+                    {
+                        waitingForWrite_ = false;
+                        boost::system::error_code ignore;
+                        timer_.cancel(ignore);
+                        if (ec)
+                            finishWrite(ec, next);
+                        else
+                            sendFilePartAsync(written, part, next);
+                    }
+                ));
+                return;
+            }
+
+            // the client went away, or the file became shorter. The promised length cannot be kept.
+            finishWrite({}, false);
+            return;
+        }
+        writeAsync(written, part + 1, next);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::copyFilePartAsync(std::size_t written, std::size_t part, bool next)
+    {
+        auto& file = fileParts_[part];
+        if (file.length == 0)
+        {
+            writeAsync(written, part + 1, next);
+            return;
+        }
+
+        copyBuffer_.resize(65536);
+        ssize_t got;
+        do {
+            auto amount = static_cast <std::size_t> (std::min <std::uint64_t> (file.length, copyBuffer_.size()));
+            got = ::pread(file.descriptor, copyBuffer_.data(), amount, static_cast <off_t> (file.offset));
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0)
+        {
+            finishWrite({}, false);
+            return;
+        }
+        file.offset += static_cast <std::uint64_t> (got);
+        file.length -= static_cast <std::uint64_t> (got);
+
+        auto self = shared_from_this();
+        boost::asio::async_write(socket_, boost::asio::buffer(copyBuffer_.data(), static_cast <std::size_t> (got)), strand_.wrap(
+            [this, self, written, part, next](boost::system::error_code const& ec, std::size_t)
+            {
+                if (ec)
+                    finishWrite(ec, next);
+                else
+                    copyFilePartAsync(written, part, next);
+            }
+        ));
+    }
+#endif
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::finishWrite(boost::system::error_code const& ec, bool next)
+    {
+        output_.clear();
+        fileParts_.clear();
+        if (!ec && next)
+        {
+            readHeadAsync();
+            return;
+        }
+
+        boost::system::error_code ignore;
+        socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore);
+        free();
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::finishRequest()
+    {
+        auto next = prepareNext();
+
+        // responses to pipelined requests are sent together.
+        if (!next || !hasBufferedHead() || ++pipelined_ >= owner_->settings_.maxPipelinedRequests)
+        {
+            output_.commit();
+            pipelined_ = 0;
+        }
+        return next;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::prepareNext()
+    {
+        input_.consume(chunkSize_);
+        chunkSize_ = 0;
+
+        // a streamed response is terminated, even if the handler did not.
+        if (chunkedWriter_)
+        {
+            chunkedWriter_->end();
+            chunkedWriter_.reset();
+        }
+
+        // a handler that did not respond properly leaves the client waiting for the end of the body.
+        auto next = keepAlive_ && responded_ && owner_->listening_.load() && discardBody();
+
+        request_.clear();
+        responded_ = false;
+        headDeadline_ = std::chrono::steady_clock::now() + owner_->settings_.idleTimeout;
+        bodyRemaining_ = 0;
+        chunked_ = false;
+        decoder_.reset();
+        return next;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::discardBody()
+    {
+        if (bodyRemaining_ <= input_.size())
+        {
+            input_.consume(bodyRemaining_);
+            bodyRemaining_ = 0;
+            return true;
+        }
+
+        // reading a large body that nobody wants is more expensive than a new connection.
+        if (asynchronous_ || bodyRemaining_ > 65536)
+            return false;
+
+        try {
+            readBody([](boost::string_view) {}, std::chrono::seconds(1));
+        } catch (InvalidRequest const&) {
+            return false;
+        }
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::prepareHeader(ResponseHeader& response, bool hasLength)
+    {
+        auto connection = response.responseHeaderPairs.find("Connection");
+        if (connection != std::end(response.responseHeaderPairs) && boost::algorithm::iequals(connection->second, "close"))
+            keepAlive_ = false;
+
+        // without a length the client can only tell the end of the body by the connection closing.
+        auto code = response.responseCode;
+        if (!hasLength && !response.isSet("Content-Length") && !response.isSet("Transfer-Encoding") && code != 204 && code != 304 && (code < 100 || code >= 200))
+            keepAlive_ = false;
+
+        response.responseHeaderPairs["Connection"] = keepAlive_ ? "keep-alive" : "close";
+        responded_ = true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view RestConnection::getCommonFields(ResponseHeader const* response, boost::string_view extraFields)
+    {
+        auto const& settings = owner_->settings_;
+
+        commonFields_.assign(extraFields.data(), extraFields.size());
+        if (settings.sendDate && (response == nullptr || !response->isSet("Date")))
+        {
+            char line[dateLineSize];
+            getDateLine(line);
+            commonFields_.append(line, dateLineSize);
+        }
+        if (!settings.serverName.empty() && (response == nullptr || !response->isSet("Server")))
+        {
+            commonFields_.append("Server: ");
+            commonFields_.append(settings.serverName);
+            commonFields_.append("\r\n");
+        }
+        return commonFields_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::writeHeader(ResponseHeader const& response, boost::string_view extraFields)
+    {
+        response.writeTo(output_, getCommonFields(&response, extraFields));
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::ostream& RestConnection::beginComposedBody()
+    {
+        body_.clear();
+        bodyStream_.clear();
+        return bodyStream_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::sendComposedBody(ResponseHeader& response)
+    {
+        response.setContentLength(body_.size());
+        prepareHeader(response);
+
+        writeHeader(response);
+        if (!isHeadRequest())
+            stream_.write(body_.data(), static_cast <std::streamsize> (body_.size()));
+        stream_.flush();
+
+        // one large body should not stay with the connection.
+        if (body_.capacity() > 65536)
+            std::string{}.swap(body_);
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::hasBufferedHead()
+    {
+        // errors count as well, so that they are reported.
+        auto received = boost::asio::buffer_cast <char const*> (input_.data());
+        return parser_.parse(received, input_.size()) != RequestParser::Result::Incomplete;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::isHeadRequest() const
+    {
+        return request_.requestType == "HEAD";
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::ostream& RestConnection::getStream()
     {
         return stream_;
     }
@@ -54,14 +671,29 @@ namespace Rest
         return id_;
     }
 //-------------------------------------------------------------------------------------------------------
-    RequestHeader RestConnection::getRequestHeader() const
+    RequestHeader const& RestConnection::getRequestHeader() const
     {
         return request_;
     }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view RestConnection::getHeaderField(boost::string_view name) const
+    {
+        return request_.entries.get(name);
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view RestConnection::getHeaderField(KnownHeader header) const
+    {
+        return request_.entries.get(header);
+    }
 //-------------------------------------------------------------------------------------------------------
     std::size_t RestConnection::getBodySize() const
     {
-        return stream_.rdbuf()->available() + stream_.rdbuf()->in_avail();
+        if (bodyRemaining_ != std::numeric_limits <std::size_t>::max())
+            return bodyRemaining_;
+
+        // the length is unknown, all that can be said is what is there.
+        boost::system::error_code ec;
+        return input_.size() - chunkSize_ + socket_.available(ec);
     }
 //-------------------------------------------------------------------------------------------------------
     std::string RestConnection::getAddress() const
@@ -73,143 +705,731 @@ namespace Rest
     {
         return endpoint_.port();
     }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t RestConnection::getShard() const
+    {
+        return shard_;
+    }
 //-------------------------------------------------------------------------------------------------------
     void RestConnection::setEndpoint(boost::asio::ip::tcp::acceptor::endpoint_type remote)
     {
         endpoint_ = remote;
     }
 //-------------------------------------------------------------------------------------------------------
-    void RestConnection::readHead()
+    RestConnection::HeadState RestConnection::readHead()
     {
-        // read first line of request.
-        stream_ >> request_.requestType;
-        stream_ >> request_.url;
-        stream_ >> request_.httpVersion;
+        auto const& settings = owner_->settings_;
+        while (!hasBufferedHead())
+        {
+            keepAlive_ = false;
+            if (headTimedOut_)
+            {
+                headTimedOut_ = false;
+                if (input_.size() == 0)
+                    return HeadState::Closed;
+                throw RequestTimeout("Timeout while reading the request header.");
+            }
 
-        if (!stream_ || request_.httpVersion.substr(0, 5) != "HTTP/")
+            // only what is there is read, the worker does not wait for the rest.
+            boost::system::error_code ec;
+            auto available = socket_.available(ec);
+            if (!ec && available == 0 && !headReadable_)
+                return HeadState::Incomplete;
+            headReadable_ = false;
+
+            auto space = settings.maxHeaderSize - std::min(input_.size(), settings.maxHeaderSize);
+            auto amount = socket_.read_some(input_.prepare(std::min(static_cast <std::size_t> (4096u), space)), ec);
+            if (ec)
+            {
+                if (input_.size() == 0)
+                    return HeadState::Closed;
+                throw InvalidRequest("Could not read the request header: " + ec.message());
+            }
+            input_.commit(amount);
+        }
+
+        headReadable_ = false;
+        headTimedOut_ = false;
+        parseHead();
+        return HeadState::Complete;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::waitForHeadAsync()
+    {
+        auto self = shared_from_this();
+        strand_.post([this, self]() {
+            // stop() has closed the waiting connections already.
+            if (!owner_->listening_.load())
+            {
+                free();
+                return;
+            }
+
+            waitingForHead_ = true;
+            timer_.expires_at(headDeadline_);
+            timer_.async_wait(strand_.wrap(
+                [this, self](boost::system::error_code const& ec)
+                {
+                    if (ec || !waitingForHead_)
+                        return;
+                    headTimedOut_ = true;
+                    boost::system::error_code ignore;
+                    socket_.cancel(ignore);
+                }
+            ));
+
+            // errors are found by the read in readHead.
+            socket_.async_wait(boost::asio::ip::tcp::socket::wait_read, strand_.wrap(
+                [this, self](boost::system::error_code const&)
+                {
+                    waitingForHead_ = false;
+                    boost::system::error_code ignore;
+                    timer_.cancel(ignore);
+                    headReadable_ = !headTimedOut_;
+                    owner_->resume(this);
+                }
+            ));
+        });
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::parseHead()
+    {
+        keepAlive_ = false;
+        auto received = boost::asio::buffer_cast <char const*> (input_.data());
+        if (parser_.parse(received, input_.size()) != RequestParser::Result::Complete)
         {
-            throw InvalidRequest("Request does not contain a valid HTTP request header.");
+            // there is no way to find the next request after garbage.
+            std::string error = parser_.getError();
+            input_.consume(input_.size());
+            parser_.reset();
+            throw InvalidRequest(error);
         }
 
+        // the receive buffer is compacted while reading the body, so the head is kept separately.
+        head_.assign(received, parser_.getHeadSize());
+        request_.clear();
+        request_.requestType = parser_.getMethod().view(head_.data());
+        request_.url = parser_.getTarget().view(head_.data());
+        request_.httpVersion = parser_.getVersion().view(head_.data());
+        for (auto const& field : parser_.getFields())
+            request_.entries.add(field.name.view(head_.data()), field.value.view(head_.data()));
+
+        input_.consume(parser_.getHeadSize());
+        parser_.reset();
+
         // validate http version
         //------------------------------------------------------------
-        auto version = request_.httpVersion.substr(5, request_.httpVersion.length() - 5);
+        auto version = request_.httpVersion.substr(5);
 
         if (version != "1.0" && version != "1.1")
             throw InvalidRequest("HTTP version is not supported");
         //------------------------------------------------------------
 
-        // Process the response headers, which are terminated by a blank line.
-        std::string headerLine;
-        std::getline(stream_, headerLine);
-        while (std::getline(stream_, headerLine))
+        // body framing and persistence
+        //------------------------------------------------------------
+        auto const& settings = owner_->settings_;
+        auto connection = request_.entries.get(KnownHeader::Connection);
+        if (request_.entries.contains(KnownHeader::TransferEncoding))
         {
-            if (headerLine == "\r")
-                break;
+            // anything but chunked as the final coding leaves no way to find the end (RFC 7230 3.3.3).
+            auto codings = request_.entries.get(KnownHeader::TransferEncoding);
+            auto last = codings.substr(std::min(codings.size(), codings.rfind(',') + 1));
+            while (!last.empty() && (last.front() == ' ' || last.front() == '\t'))
+                last.remove_prefix(1);
+            if (!boost::algorithm::iequals(last, "chunked"))
+                throw InvalidRequest("Transfer-Encoding does not end with chunked.");
 
-            auto pos = headerLine.find(":");
-            if (pos == std::string::npos)
-                throw InvalidRequest("HTTP header entry does not contain colon");
-
-            auto lhs = headerLine.substr(0, pos);
-            auto rhs = headerLine.substr(pos + 1, headerLine.length() - pos);
-
-            request_.entries[lhs] = rhs;
+            // the length is unknown until the last chunk has been decoded.
+            chunked_ = true;
+            bodyRemaining_ = std::numeric_limits <std::size_t>::max();
+        }
+        else if (request_.entries.contains(KnownHeader::ContentLength))
+        {
+            bodyRemaining_ = parseContentLength(request_.entries.get(KnownHeader::ContentLength));
+            if (bodyRemaining_ > settings.maxBodySize)
+                throw InvalidRequest("Request body is too large.", 413);
         }
 
+        if (version == "1.1")
+            keepAlive_ = !boost::algorithm::icontains(connection, "close");
+        else
+            keepAlive_ = boost::algorithm::icontains(connection, "keep-alive");
+        keepAlive_ = keepAlive_ && settings.keepAlive && ++requestCount_ < settings.maxKeepAliveRequests;
+        //------------------------------------------------------------
     }
 //-------------------------------------------------------------------------------------------------------
     void RestConnection::sendFile(std::string const& fileName, bool autoDetectContentType, ResponseHeader response)
     {
+        FileStatus status;
+        auto* fileCache = owner_->shards_[shard_]->fileCache.get();
+        if (fileCache)
+        {
+            auto file = fileCache->get(fileName, &status);
+            if (file)
+            {
+                sendCachedFile(fileName, file, autoDetectContentType, response);
+                return;
+            }
+        }
+
+#ifdef __linux__
+        // a miss of the file cache has looked at the file just now, so it is not stat'ed again.
+        // a file replaced in between breaks the promised length, which closes the connection like a shortened file does.
+        if (status.checked && !status.exists)
+            throw std::runtime_error("Could not open file.");
+        // shared, asynchronous connections send the contents after the handler has returned.
+        auto file = std::make_shared <FileHandle> (::open(fileName.c_str(), O_RDONLY | O_CLOEXEC));
+        if (file->get() < 0)
+            throw std::runtime_error("Could not open file.");
+        if (!status.checked)
+        {
+            struct stat info;
+            if (::fstat(file->get(), &info) != 0 || !S_ISREG(info.st_mode))
+                throw std::runtime_error("Could not open file.");
+            status.size = static_cast <std::uint64_t> (info.st_size);
+            status.modified = static_cast <std::int64_t> (info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        }
+        auto size = status.size;
+        auto modified = status.modified;
+        auto sendPart = [&](std::uint64_t offset, std::uint64_t length) {
+            sendFileContent(file->get(), offset, length, file);
+        };
+#else
         std::ifstream reader(fileName, std::ios_base::binary);
 
         if (!reader.good())
             throw std::runtime_error("Could not open file.");
 
         reader.seekg(0, reader.end);
-        auto size = reader.tellg();
+        auto size = static_cast <std::uint64_t> (reader.tellg());
         reader.seekg(0, reader.beg);
+        auto modified = unknownModification;
+        auto sendPart = [&](std::uint64_t offset, std::uint64_t length) {
+            char buffer[65536];
+            reader.clear();
+            reader.seekg(static_cast <std::streamoff> (offset));
+            while (length != 0 && reader.read(buffer, static_cast <std::streamsize> (std::min <std::uint64_t> (length, sizeof(buffer)))).gcount() > 0)
+            {
+                stream_.write(buffer, reader.gcount());
+                length -= static_cast <std::uint64_t> (reader.gcount());
+            }
+        };
+#endif
+
+        std::string validatorFields;
+        if (checkFileConditions(size, modified, response, validatorFields))
+            return;
+        if (sendFileRanges(fileName, autoDetectContentType, size, modified, validatorFields, response, sendPart))
+            return;
+
+        writeFileHeader(fileName, autoDetectContentType, size, response, validatorFields);
+        if (size == 0 || isHeadRequest())
+            return;
 
+#ifdef __linux__
+        sendFileContent(file->get(), 0, size, file);
+#else
+        char buffer[65536];
+        do {
+            reader.read(buffer, 65536);
+            stream_.write(buffer, reader.gcount());
+        } while (reader.gcount() == 65536);
+#endif
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::writeFileHeader(std::string const& fileName, bool autoDetectContentType, std::uint64_t size, ResponseHeader& response,
+                                         boost::string_view validatorFields)
+    {
         if (autoDetectContentType) {
             auto extension = extractFileExtension(fileName);
             auto type = extensionToMimeType(extension);
             if (!type.empty())
                 response["Content-Type"] = type;
         }
-        response["Content-Length"] = std::to_string(size);
+        response.setContentLength(size);
+        if (size != 0 && !response.isSet("Accept-Ranges"))
+            response["Accept-Ranges"] = "bytes";
 
         if (size == 0)
         {
             response.responseCode = 204;
             response.responseString = "No Content";
         }
-        stream_ << response.toString();
+        prepareHeader(response);
+        writeHeader(response, validatorFields);
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::sendStaticFile(std::string const& fileName, ResponseHeader response)
+    {
+        auto* fileCache = owner_->shards_[shard_]->fileCache.get();
+        if (fileCache)
+        {
+            auto file = fileCache->get(fileName);
+            if (file)
+            {
+                sendCachedFile(fileName, file, true, response);
+                return true;
+            }
+        }
 
-        if (size == 0)
+#ifdef _WIN32
+        std::ifstream probe(fileName, std::ios_base::binary);
+        if (!probe.good())
+            return false;
+        probe.close();
+        sendFile(fileName, true, std::move(response));
+#else
+        auto file = owner_->shards_[shard_]->openFiles->get(fileName);
+        if (!file)
+            return false;
+
+        auto size = file->getSize();
+        auto sendPart = [this, &file](std::uint64_t offset, std::uint64_t length) {
+            sendFileContent(file->getDescriptor(), offset, length, file);
+        };
+        std::string validatorFields;
+        if (checkFileConditions(size, file->getModified(), response, validatorFields))
+            return true;
+        if (sendFileRanges(fileName, true, size, file->getModified(), validatorFields, response, sendPart))
+            return true;
+
+        writeFileHeader(fileName, true, size, response, validatorFields);
+        if (size != 0 && !isHeadRequest())
+            sendFileContent(file->getDescriptor(), 0, size, file);
+#endif
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::sendCachedFile(std::string const& fileName, std::shared_ptr <CachedFile const> const& cached, bool autoDetectContentType, ResponseHeader& response)
+    {
+        auto const& file = *cached;
+        auto sendPart = [this, &file](std::uint64_t offset, std::uint64_t length) {
+            stream_.write(file.contents.data() + offset, static_cast <std::streamsize> (length));
+        };
+        // validators set by the response replace the cached ones.
+        auto ownValidators = !response.isSet("ETag") && !response.isSet("Last-Modified");
+        auto validatorFields = ownValidators ? file.getValidatorFields() : boost::string_view{};
+        if (ownValidators && sendNotModified(file.entityTag, file.modified, validatorFields, response))
+            return;
+        if (sendFileRanges(fileName, autoDetectContentType, file.contents.size(), file.modified, validatorFields, response, sendPart))
             return;
 
+        // the cached fields replace those of the response, as sendFile sets them otherwise.
+        auto withType = autoDetectContentType && file.typeFieldSize != 0;
+        response.responseHeaderPairs.erase("Content-Length");
+        if (withType)
+            response.responseHeaderPairs.erase("Content-Type");
+
+        // fields the response sets itself are left out of the cached ones, which is rare and costs a copy.
+        auto fields = file.getFields(withType);
+        auto ownAcceptRanges = !response.isSet("Accept-Ranges");
+        std::string composed;
+        if (!ownValidators || !ownAcceptRanges)
+        {
+            composed = file.composeFields(withType, ownValidators, ownAcceptRanges);
+            fields = composed;
+        }
+
+        prepareHeader(response, true);
+        writeHeader(response, fields);
+        if (isHeadRequest())
+            return;
+
+        if (asynchronous_)
+        {
+            fileParts_.push_back(FilePart {output_.size(), cached, file.contents.data(), -1, 0, file.contents.size()});
+            return;
+        }
+
+        std::array <boost::asio::const_buffer, 2> buffers {{
+            boost::asio::buffer(output_.data(), output_.size()),
+            boost::asio::buffer(file.contents)
+        }};
+        boost::system::error_code ec;
+        boost::asio::write(socket_, buffers, ec);
+        output_.clear();
+        if (ec)
+            keepAlive_ = false;
+    }
+//-------------------------------------------------------------------------------------------------------
+    constexpr std::int64_t RestConnection::unknownModification;
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::checkFileConditions(std::uint64_t size, std::int64_t modified, ResponseHeader& response, std::string& validatorFields)
+    {
+        if (modified == unknownModification || response.isSet("ETag") || response.isSet("Last-Modified"))
+            return false;
+
+        validatorFields = makeFileValidatorFields(size, modified);
+        return sendNotModified(makeFileEntityTag(size, modified), modified, validatorFields, response);
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::sendNotModified(boost::string_view entityTag, std::int64_t modified, boost::string_view validatorFields, ResponseHeader& response)
+    {
+        if ((request_.requestType != "GET" && request_.requestType != "HEAD") || response.responseCode != 200 || entityTag.empty())
+            return false;
+
+        // If-None-Match takes precedence, If-Modified-Since is then ignored.
+        if (request_.entries.contains(KnownHeader::IfNoneMatch))
+        {
+            if (!matchesEntityTag(request_.entries.get(KnownHeader::IfNoneMatch), entityTag))
+                return false;
+        }
+        else
+        {
+            // dates in the future are invalid, the file might still change within the current second.
+            std::time_t since;
+            auto condition = request_.entries.get(KnownHeader::IfModifiedSince);
+            if (condition.empty() || !parseHttpDate(condition, since) || since > std::time(nullptr) ||
+                static_cast <std::time_t> (modified / 1000000000) > since)
+                return false;
+        }
+
+        response.responseCode = 304;
+        response.responseString = translateResponseCode(304);
+        response.responseHeaderPairs.erase("Content-Length");
+        response.responseHeaderPairs.erase("Content-Type");
+        prepareHeader(response);
+        writeHeader(response, validatorFields);
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::sendFileRanges(std::string const& fileName, bool autoDetectContentType, std::uint64_t size, std::int64_t modified,
+                                        boost::string_view validatorFields, ResponseHeader& response, std::function <void(std::uint64_t, std::uint64_t)> const& sendPart)
+    {
+        // ranges only apply to successful GET requests, unless the response turns them off.
+        auto range = request_.entries.get(KnownHeader::Range);
+        if (range.empty() || request_.requestType != "GET" || response.responseCode != 200 || size == 0)
+            return false;
+        auto acceptRanges = response.responseHeaderPairs.find("Accept-Ranges");
+        if (acceptRanges != std::end(response.responseHeaderPairs) && boost::algorithm::iequals(acceptRanges->second, "none"))
+            return false;
+
+        // an outdated client copy needs the whole file. If-Range compares strongly, so weak tags never match.
+        if (request_.entries.contains(KnownHeader::IfRange))
+        {
+            auto condition = request_.entries.get(KnownHeader::IfRange);
+            if (!condition.empty() && condition.front() == '"')
+            {
+                auto tag = response.responseHeaderPairs.find("ETag");
+                if (tag == std::end(response.responseHeaderPairs) || condition != tag->second)
+                    return false;
+            }
+            else if (modified == unknownModification || condition != formatHttpDate(static_cast <std::time_t> (modified / 1000000000)))
+                return false;
+        }
+
+        std::vector <ByteRange> ranges;
+        auto result = parseByteRanges(range, size, ranges);
+        if (result == RangeResult::Full)
+            return false;
+
+        auto type = autoDetectContentType ? extensionToMimeType(extractFileExtension(fileName)) : std::string{};
+        auto given = response.responseHeaderPairs.find("Content-Type");
+        if (type.empty() && given != std::end(response.responseHeaderPairs))
+            type = given->second;
+        response.responseHeaderPairs.erase("Content-Type");
+
+        auto totalSize = std::to_string(size);
+        if (result == RangeResult::Unsatisfiable)
+        {
+            response.responseCode = 416;
+            response.responseString = translateResponseCode(416);
+            response["Content-Range"] = "bytes */" + totalSize;
+            response.setContentLength(0);
+            prepareHeader(response);
+            writeHeader(response);
+            return true;
+        }
+
+        response.responseCode = 206;
+        response.responseString = translateResponseCode(206);
+        response["Accept-Ranges"] = "bytes";
+
+        auto contentRange = [&totalSize](ByteRange const& part) {
+            return "bytes " + std::to_string(part.first) + "-" + std::to_string(part.first + part.length - 1) + "/" + totalSize;
+        };
+
+        if (ranges.size() == 1)
+        {
+            if (!type.empty())
+                response["Content-Type"] = type;
+            response["Content-Range"] = contentRange(ranges.front());
+            response.setContentLength(ranges.front().length);
+            prepareHeader(response);
+            writeHeader(response, validatorFields);
+            sendPart(ranges.front().first, ranges.front().length);
+            return true;
+        }
+
+        // several ranges are sent as multipart/byteranges, the length is known from the part headers.
+        static thread_local std::mt19937_64 random {std::random_device{}()};
+        char boundary[17];
+        auto value = random();
+        for (std::size_t i = 0; i != 16; ++i)
+            boundary[i] = "0123456789abcdef"[(value >> (i * 4)) & 0xF];
+        boundary[16] = '\0';
+
+        std::vector <std::string> partHeaders;
+        std::uint64_t length = 0;
+        for (auto const& part : ranges)
+        {
+            std::string header = "\r\n--";
+            header += boundary;
+            header += "\r\n";
+            if (!type.empty())
+                header += "Content-Type: " + type + "\r\n";
+            header += "Content-Range: " + contentRange(part) + "\r\n\r\n";
+            length += header.size() + part.length;
+            partHeaders.push_back(std::move(header));
+        }
+        std::string closing = "\r\n--";
+        closing += boundary;
+        closing += "--\r\n";
+        length += closing.size();
+
+        response["Content-Type"] = std::string{"multipart/byteranges; boundary="} + boundary;
+        response.setContentLength(length);
+        prepareHeader(response);
+        writeHeader(response, validatorFields);
+        for (std::size_t i = 0; i != ranges.size(); ++i)
+        {
+            stream_ << partHeaders[i];
+            sendPart(ranges[i].first, ranges[i].length);
+        }
+        stream_ << closing;
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+#ifndef _WIN32
+    bool RestConnection::sendFileContent(int file, std::uint64_t offset, std::uint64_t length, std::shared_ptr <void const> const& owner)
+    {
+#   ifndef __linux__
+        // asynchronous connections keep the copy in the output buffer until the handler has returned.
+        (void)owner;
+        if (!asynchronous_)
+            output_.commit();
+        return copyFileContent(file, offset, length);
+#   else
+        if (asynchronous_)
+        {
+            fileParts_.push_back(FilePart {output_.size(), owner, nullptr, file, offset, length});
+            return true;
+        }
+
+        // the header and earlier pipelined responses go first.
+        output_.commit();
+
+        PipeSignalBlock noPipeSignal;
+        auto position = static_cast <off_t> (offset);
+        while (length != 0)
+        {
+            auto amount = static_cast <std::size_t> (std::min <std::uint64_t> (length, 1u << 30));
+            auto sent = ::sendfile(socket_.native_handle(), file, &position, amount);
+            if (sent > 0)
+            {
+                length -= static_cast <std::uint64_t> (sent);
+                continue;
+            }
+
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent < 0 && (errno == EINVAL || errno == ENOSYS))
+                return copyFileContent(file, static_cast <std::uint64_t> (position), length);
+
+            // the socket is non-blocking once it has waited for a request asynchronously. a client that stops reading is given up on like an idle one.
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && waitWritable(owner_->settings_.idleTimeout))
+                continue;
+
+            // the client went away, or the file became shorter. The promised length cannot be kept.
+            keepAlive_ = false;
+            return false;
+        }
+        return true;
+#   endif
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::copyFileContent(int file, std::uint64_t offset, std::uint64_t length)
+    {
         char buffer[65536];
-        do {
-            reader.read(buffer, 65536);
-            stream_.write(buffer, reader.gcount());
-        } while (reader.gcount() == 65536);
+        while (length != 0)
+        {
+            auto amount = static_cast <std::size_t> (std::min <std::uint64_t> (length, sizeof(buffer)));
+            auto got = ::pread(file, buffer, amount, static_cast <off_t> (offset));
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+            {
+                keepAlive_ = false;
+                return false;
+            }
+            stream_.write(buffer, got);
+            offset += static_cast <std::uint64_t> (got);
+            length -= static_cast <std::uint64_t> (got);
+        }
+        return true;
     }
+#endif
 //-------------------------------------------------------------------------------------------------------
     void RestConnection::sendString(std::string const& text, ResponseHeader response)
     {
-        response.responseHeaderPairs["Content-Length"] = std::to_string(text.length());
+        response.setContentLength(text.length());
         if (response.responseHeaderPairs.find("Content-Type") == std::end(response.responseHeaderPairs))
             response.responseHeaderPairs["Content-Type"] = "text/plain; charset=UTF-8";
 
-        stream_ << response.toString();
-        if (response.responseCode != 204)
+        prepareHeader(response);
+        writeHeader(response);
+        if (response.responseCode != 204 && !isHeadRequest())
             stream_ << text;
     }
+//-------------------------------------------------------------------------------------------------------
+    bool RestConnection::sendCannedStatus(int statusCode)
+    {
+        // the response has a length, so it does not affect keep-alive.
+        auto canned = getCannedResponse(statusCode, keepAlive_, !isHeadRequest());
+        if (canned.head.empty())
+            return false;
+
+        responded_ = true;
+        auto commonFields = getCommonFields(nullptr);
+        output_.sputn(canned.head.data(), static_cast <std::streamsize> (canned.head.size()));
+        output_.sputn(commonFields.data(), static_cast <std::streamsize> (commonFields.size()));
+        output_.sputn("\r\n", 2);
+        output_.sputn(canned.body.data(), static_cast <std::streamsize> (canned.body.size()));
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    ChunkedWriter& RestConnection::sendChunked(ResponseHeader response, std::size_t coalesceSize)
+    {
+        // HTTP/1.0 clients do not know chunks, for them the body ends with the connection.
+        auto chunked = request_.httpVersion != "HTTP/1.0";
+        response.responseHeaderPairs.erase("Content-Length");
+        if (chunked)
+            response.responseHeaderPairs["Transfer-Encoding"] = "chunked";
+        if (response.responseHeaderPairs.find("Content-Type") == std::end(response.responseHeaderPairs))
+            response.responseHeaderPairs["Content-Type"] = "text/plain; charset=UTF-8";
+
+        prepareHeader(response);
+        writeHeader(response);
+
+        chunkedWriter_.reset(new ChunkedWriter(stream_, [this]() { output_.commit(); }, coalesceSize, chunked, isHeadRequest()));
+        return *chunkedWriter_;
+    }
 //-------------------------------------------------------------------------------------------------------
     void RestConnection::sendHeader(ResponseHeader response)
     {
-        stream_ << response.toString();
+        prepareHeader(response);
+        writeHeader(response);
     }
 //-------------------------------------------------------------------------------------------------------
-    void RestConnection::read(std::function <void(char const*, long)> writer, std::chrono::duration <long> const& timeout)
+    boost::string_view RestConnection::readBodyChunk(std::chrono::milliseconds timeout)
     {
-        int amount = 0;
-        do {
-            char buffer[4096];
-            amount = std::min(getBodySize(), static_cast <std::size_t> (4096u));
-            if (amount == 0) {
-                auto now = std::chrono::high_resolution_clock::now();
-                do {
-                    if (getBodySize() > 0)
-                        break;
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                } while ((std::chrono::high_resolution_clock::now() - now) < timeout);
-                if (getBodySize() == 0)
+        // the previous chunk has been processed.
+        input_.consume(chunkSize_);
+        chunkSize_ = 0;
+
+        if (bodyRemaining_ == 0)
+            return {};
+
+        if (chunked_)
+            return decodeBodyChunk(timeout);
+
+        // whatever has been received together with the head comes first.
+        if (input_.size() == 0)
+            receiveBody(timeout);
+
+        chunkSize_ = std::min(input_.size(), bodyRemaining_);
+        bodyRemaining_ -= chunkSize_;
+        return {boost::asio::buffer_cast <char const*> (input_.data()), chunkSize_};
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view RestConnection::decodeBodyChunk(std::chrono::milliseconds timeout)
+    {
+        for (;;)
+        {
+            if (input_.size() == 0)
+                receiveBody(timeout);
+
+            std::size_t consumed = 0;
+            boost::string_view chunk;
+            switch (decoder_.decode(boost::asio::buffer_cast <char const*> (input_.data()), input_.size(), consumed, chunk))
+            {
+                case (ChunkedDecoder::Result::Data):
+                    // the framing in front is dropped together with the data on the next call.
+                    chunkSize_ = consumed;
+                    return chunk;
+                case (ChunkedDecoder::Result::NeedMore):
+                    input_.consume(consumed);
                     break;
-                amount = std::min(getBodySize(), static_cast <std::size_t> (4096u));
+                case (ChunkedDecoder::Result::Complete):
+                    input_.consume(consumed);
+                    bodyRemaining_ = 0;
+                    return {};
+                case (ChunkedDecoder::Result::Error):
+                    keepAlive_ = false;
+                    throw InvalidRequest(decoder_.getError(), decoder_.isTooLarge() ? 413 : 400);
             }
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestConnection::receiveBody(std::chrono::milliseconds timeout)
+    {
+        // the io thread waits here, as handlers read synchronously. It is not held longer than the body timeout.
+        if (asynchronous_)
+            timeout = std::min(timeout, owner_->settings_.bodyTimeout);
 
-            stream_.read(buffer, amount);
-            writer(buffer, amount);
-        } while (amount == 4096);
+        if (!waitReadable(timeout))
+        {
+            keepAlive_ = false;
+            throw RequestTimeout("Timeout while reading the request body.");
+        }
+
+        boost::system::error_code ec;
+        auto amount = socket_.read_some(input_.prepare(std::min(bodyRemaining_, static_cast <std::size_t> (65536u))), ec);
+        if (ec)
+        {
+            keepAlive_ = false;
+            throw InvalidRequest("The request body is incomplete.");
+        }
+        input_.commit(amount);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::vector <ChunkedDecoder::Trailer> const& RestConnection::getTrailers() const
+    {
+        return decoder_.getTrailers();
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t RestConnection::readBody(std::function <void(boost::string_view)> const& onData, std::chrono::milliseconds timeout)
+    {
+        std::size_t total = 0;
+        for (auto chunk = readBodyChunk(timeout); !chunk.empty(); chunk = readBodyChunk(timeout))
+        {
+            onData(chunk);
+            total += chunk.size();
+        }
+        return total;
     }
 //-------------------------------------------------------------------------------------------------------
     std::string RestConnection::readString(std::chrono::duration <long> const& timeout)
     {
         std::string result;
-        read([&](char const* buffer, long amount) { result.append(buffer, amount); }, timeout);
+
+        // the length is announced by the client, so do not trust it too much.
+        if (bodyRemaining_ != std::numeric_limits <std::size_t>::max())
+            result.reserve(std::min(bodyRemaining_, static_cast <std::size_t> (16u * 1024u * 1024u)));
+
+        readBody([&](boost::string_view chunk) { result.append(chunk.data(), chunk.size()); }, timeout);
         return result;
     }
 //-------------------------------------------------------------------------------------------------------
     std::ostream& RestConnection::readStream(std::ostream& stream, std::chrono::duration <long> const& timeout)
     {
-        read([&](char const* buffer, long amount) { stream.write(buffer, amount); }, timeout);
+        readBody([&](boost::string_view chunk) { stream.write(chunk.data(), chunk.size()); }, timeout);
         return stream;
     }
 //-------------------------------------------------------------------------------------------------------
     bool RestConnection::isBodyEmpty()
     {
-        return getBodySize() == 0;
+        return bodyRemaining_ == 0;
     }
 //#######################################################################################################
 } // namespace Rest
@@ -6,6 +6,11 @@
 #include "exceptions.hpp"
 #include "response_header.hpp"
 #include "request_header.hpp"
+#include "output_buffer.hpp"
+#include "request_parser.hpp"
+#include "chunked_decoder.hpp"
+#include "chunked_writer.hpp"
+#include "file_cache.hpp"
 
 #ifndef Q_MOC_RUN // A Qt workaround, for those of you who use Qt
 #   ifdef SREST_SUPPORT_JSON
@@ -28,6 +33,9 @@
 #include <cmath>
 #include <chrono>
 #include <functional>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace Rest {
 
@@ -44,13 +52,14 @@ namespace Rest {
         ~RestConnection() = default;
 
         /**
-         *  Returns the socket iostream for writing.
-         *  Do not read the header from it.
+         *  Returns the stream for writing to the client.
+         *  Writes are buffered and passed to the socket in large pieces.
          *  It is recommended to call flush after writing everything to the stream.
+         *  On asynchronous connections the data is sent once the handler returns.
          *
-         *  @return A tcp::iostream. See boost asio documentation.
+         *  @return An output stream connected to the socket.
          */
-        boost::asio::ip::tcp::iostream& getStream();
+        std::ostream& getStream();
 
         /**
          *  Returns the connected clients id.
@@ -60,14 +69,24 @@ namespace Rest {
         UserId getId() const;
 
         /**
-         *  Returns the request header
+         *  Returns the request header.
+         *  It refers to memory of the connection and is only valid while the current request is served.
          *
          *  @return A header containing the key:value pairs.
          */
-        RequestHeader getRequestHeader() const;
+        RequestHeader const& getRequestHeader() const;
 
         /**
-         *  Returns the size of the body.
+         *  Returns a field of the request header, case insensitive.
+         *
+         *  @return The value or an empty view, if the field was not sent. Valid while the request is served.
+         */
+        boost::string_view getHeaderField(boost::string_view name) const;
+        boost::string_view getHeaderField(KnownHeader header) const;
+
+        /**
+         *  Returns the size of the body that has not been read yet, as announced by Content-Length.
+         *  For bodies without a length (Transfer-Encoding) only what has been received so far.
          *
          *  @return body size.
          */
@@ -87,6 +106,14 @@ namespace Rest {
          */
         uint32_t getPort() const;
 
+        /**
+         *  Returns the index of the core (server shard) serving this connection.
+         *  Always 0 unless the server runs in ServerMode::PerCore.
+         *
+         *  @return Shard index.
+         */
+        std::size_t getShard() const;
+
 #ifdef SREST_SUPPORT_JSON
         /**
          *  Send JSON response. uses SimpleJSON library to stringify the object.
@@ -94,7 +121,7 @@ namespace Rest {
          *
          *  Content-Type: text/json; charset=UTF-8
          *  Content-Length: ...
-         *  Connection: close
+         *  Connection: keep-alive or close
          *
          *  @param object An object to stringify.
          *  @param responseHeader A response header containing header information,
@@ -107,20 +134,12 @@ namespace Rest {
 
             response.responseHeaderPairs["Content-Type"s] = "text/json; charset=UTF-8"s;
 
-            std::stringstream body;
+            auto& body = beginComposedBody();
             body << '{';
             JSON::try_stringify(body, "", object);
             body << '}';
 
-            auto bodySize = body.tellp();
-            response.responseHeaderPairs["Content-Length"s] = std::to_string(bodySize);
-            response.responseHeaderPairs["Connection"s] = "close"s;
-
-            body.seekg(0);
-
-            stream_ << response.toString();
-            stream_ << body.rdbuf();
-            stream_.flush();
+            sendComposedBody(response);
         }
 #endif // SREST_SUPPORT_JSON
 
@@ -131,7 +150,7 @@ namespace Rest {
          *
          *  Content-Type: text/xml; charset=UTF-8
          *  Content-Length: ...
-         *  Connection: close
+         *  Connection: keep-alive or close
          *
          *  @param object An object to xmlify.
          *  @param name The name of the root xml node, as such is required.
@@ -145,31 +164,39 @@ namespace Rest {
 
             response.responseHeaderPairs["Content-Type"s] = "text/xml; charset=UTF-8"s;
 
-            std::stringstream body;
+            auto& body = beginComposedBody();
             body << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
             SXML::xmlify(body, name, object);
 
-            auto bodySize = body.tellp();
-            response.responseHeaderPairs["Content-Length"s] = std::to_string(bodySize);
-            response.responseHeaderPairs["Connection"s] = "close"s;
-
-            body.seekg(0);
-
-            stream_ << response.toString();
-            stream_ << body.rdbuf();
-            stream_.flush();
+            sendComposedBody(response);
         }
 #endif // SREST_SUPPORT_XML
 
+        /**
+         *  Sends a prepared response with the reason phrase as body, see getCannedResponse.
+         *  Does the same as sending the reason phrase with sendString and a fresh header, but in one piece.
+         *
+         *  @return false if there is no prepared response for the code. Nothing is sent then.
+         */
+        bool sendCannedStatus(int statusCode);
+
         /**
          *  Sends a file as content.
          *  The response will be 204 for empty files and whats provided otherwise,
          *  which might be 200 if no explicit response header is provided.
          *  It does not send error codes on itself, but throws when the file cannot be opened.
+         *  On Linux the file is passed to the socket by the kernel (sendfile), without copying it through this process.
          *
          *  Automatically sets the following header key/value pairs
          *
          *  Content-Length: ...
+         *  Connection: keep-alive or close
+         *  Accept-Ranges: bytes
+         *  ETag: W/"..." and Last-Modified: ..., unless the response sets either of them
+         *
+         *  Range requests are answered with 206 (Partial Content). GET and HEAD requests whose
+         *  If-None-Match or If-Modified-Since condition shows that the client has the file already
+         *  are answered with 304 (Not Modified) and no body.
          *
          *  @param fileName A file to send.
          *  @param responseHeader A response header containing header information,
@@ -177,6 +204,18 @@ namespace Rest {
          */
         void sendFile(std::string const& fileName, bool autoDetectContentType = true, ResponseHeader response = {});
 
+        /**
+         *  Sends a file like sendFile, for serving a directory (see InterfaceProvider::serveStatic).
+         *  Files are taken from the FileCache if it is on, otherwise from the server's cache of open files,
+         *  so that frequently requested files are neither opened nor stat'ed again each time.
+         *  The content type is always detected.
+         *
+         *  @param fileName The file, its path must have been checked by the caller.
+         *
+         *  @return false if there is no regular file. Nothing is sent then.
+         */
+        bool sendStaticFile(std::string const& fileName, ResponseHeader response = {});
+
         /**
          *  Sends a string. You must set the content type yourself on the response parameter.
          *  Therefore the parameter is not optional.
@@ -186,6 +225,7 @@ namespace Rest {
          *  Automatically sets the following header key/value pairs
          *
          *  Content-Length: text.length()
+         *  Connection: keep-alive or close
          *
          *  @param text A text to send.
          *  @param response A response header containing header information,
@@ -193,8 +233,27 @@ namespace Rest {
          */
         void sendString(std::string const& text, ResponseHeader response);
 
+        /**
+         *  Sends the header and returns a stream for the body, for bodies whose length is not known up front.
+         *  The body is sent with "Transfer-Encoding: chunked" (or until the connection closes for HTTP/1.0 clients).
+         *  Written data is collected until coalesceSize bytes are pending and then sent as one chunk.
+         *  Flush the stream to send what has been written so far immediately.
+         *  The body is terminated when the handler returns, or by calling end on the stream.
+         *
+         *  Asynchronous connections write chunks with blocking writes, occupying the io thread.
+         *
+         *  @param response A response header containing header information,
+         *         such as response code, version and response message.
+         *  @param coalesceSize Size of the chunks, unless flushed earlier.
+         *
+         *  @return A stream valid until the handler returns.
+         */
+        ChunkedWriter& sendChunked(ResponseHeader response, std::size_t coalesceSize = 8192);
+
         /**
          *  Sends only the header and an empty body.
+         *  The connection is closed afterwards, unless the header contains a Content-Length
+         *  (then the body is expected to be written to getStream) or the code implies an empty body.
          *
          *  @param response The header information to send.
          */
@@ -206,6 +265,11 @@ namespace Rest {
          *  We would not recommend to mix data in a single request, use multiple
          *  request or the convenience of JSON.
          *
+         *  @param timeout The client may pause for this long, before the read fails with RequestTimeout.
+         *
+         *  @throw RequestTimeout The client stopped sending.
+         *  @throw InvalidRequest The client closed the connection before sending the whole body.
+         *
          *  @return The body.
          */
         std::string readString(std::chrono::duration <long> const& timeout = 3s);
@@ -217,9 +281,46 @@ namespace Rest {
          *  We would not recommend to mix data in a single request, use multiple
          *  request or the convenience of JSON.
          *
+         *  @param timeout The client may pause for this long, before the read fails with RequestTimeout.
+         *
+         *  @throw RequestTimeout The client stopped sending.
+         *  @throw InvalidRequest The client closed the connection before sending the whole body.
+         *
          *  @return The passed stream
          */
         std::ostream& readStream(std::ostream& stream, std::chrono::duration <long> const& timeout = 3s);
+
+        /**
+         *  Returns the next piece of the body, straight from the receive buffer, without copying.
+         *  The socket is only read when the next piece is requested, so memory use does not
+         *  grow with the body size.
+         *  Reads exactly the announced length, chunked bodies are decoded on the fly.
+         *
+         *  @param timeout The client may pause for this long, before the read fails with RequestTimeout.
+         *
+         *  @throw RequestTimeout The client stopped sending.
+         *  @throw InvalidRequest The client closed the connection before sending the whole body.
+         *
+         *  @return The next piece, valid until the next call or the end of the request.
+         *          Empty once the whole body has been read.
+         */
+        boost::string_view readBodyChunk(std::chrono::milliseconds timeout = 3s);
+
+        /**
+         *  Passes the body piece by piece to a callback, see readBodyChunk.
+         *  The next piece is only read once the callback returns.
+         *
+         *  @param onData Called for every piece. The view is only valid during the call.
+         *  @param timeout The client may pause for this long, before the read fails with RequestTimeout.
+         *
+         *  @return The amount of bytes read.
+         */
+        std::size_t readBody(std::function <void(boost::string_view)> const& onData, std::chrono::milliseconds timeout = 3s);
+
+        /**
+         *  Returns the trailer fields of a chunked body. Only available after the whole body has been read.
+         */
+        std::vector <ChunkedDecoder::Trailer> const& getTrailers() const;
 
 #ifdef SREST_SUPPORT_JSON
         /**
@@ -232,7 +333,12 @@ namespace Rest {
         template <typename T>
         void readJson(T& object, std::chrono::duration <long> const& timeout = 3s)
         {
-            auto json = "{\"content\":" + readString(timeout) + "}";
+            std::string json = "{\"content\":";
+            if (bodyRemaining_ != std::numeric_limits <std::size_t>::max())
+                json.reserve(json.size() + std::min(bodyRemaining_, static_cast <std::size_t> (16u * 1024u * 1024u)) + 1);
+            readBody([&](boost::string_view chunk) { json.append(chunk.data(), chunk.size()); }, timeout);
+            json.push_back('}');
+
             auto tree = JSON::parse_json(json);
             JSON::parse(object, "content", tree);
         }
@@ -251,35 +357,343 @@ namespace Rest {
          *  Users shall never create a connection on their own,
          *  this makes no sense.
          */
-        RestConnection(RestServer* owner, UserId const& id);
+        RestConnection(RestServer* owner, UserId const& id, boost::asio::io_service& service, std::size_t shard);
+
+        /**
+         *  How far readHead got.
+         */
+        enum class HeadState
+        {
+            Complete, // parsed, the request can be handled.
+            Incomplete, // more is to come, see waitForHeadAsync.
+            Closed // the connection was closed or idle before a request started.
+        };
+
+        /**
+         *  Reads what has arrived of the next request head without waiting and parses it once it is complete. (Threaded mode)
+         *
+         *  @throw RequestTimeout if the idle time ran out in the middle of a head, InvalidRequest
+         */
+        HeadState readHead();
+
+        /**
+         *  Waits for more of the head without holding a worker, then hands the connection back to the workers.
+         *  Gives up when the idle time is over. (Threaded mode)
+         */
+        void waitForHeadAsync();
+
+        /**
+         *  Closes the socket if the connection waits in waitForHeadAsync. Thread safe.
+         */
+        void closeIfWaiting();
+
+        /**
+         *  Parses a completely received head and decides on keep-alive.
+         */
+        void parseHead();
+
+        /**
+         *  Starts serving an asynchronous connection.
+         */
+        void start();
+
+        /**
+         *  Reads the next head asynchronously. Closes the connection when it stays idle for too long.
+         */
+        void readHeadAsync();
+
+        /**
+         *  Receives more of the head.
+         */
+        void receiveHeadAsync();
+
+        /**
+         *  Parses a head that has been received asynchronously and continues with the body.
+         */
+        void processHead();
+
+        /**
+         *  Reads the body asynchronously, if it is small enough. Then calls the handler.
+         */
+        void readBodyAsync();
+
+        /**
+         *  Writes the buffered response asynchronously.
+         *  Then either reads the next request or closes the connection.
+         *  Pipelined requests that are already received are answered before writing.
+         */
+        void finish();
+
+        /**
+         *  Writes the output buffer from an offset on, together with the queued file parts from an index on.
+         *  Cached contents go out in one gather write with the output around them.
+         *
+         *  @param next Whether the connection serves another request afterwards.
+         */
+        void writeAsync(std::size_t written, std::size_t part, bool next);
+
+#ifdef __linux__
+        /**
+         *  Sends a queued part from its descriptor with sendfile, waiting asynchronously while the socket is full.
+         *  Then continues with writeAsync.
+         */
+        void sendFilePartAsync(std::size_t written, std::size_t part, bool next);
+
+        /**
+         *  The same as sendFilePartAsync, reading the file piece by piece.
+         *  For file systems that do not support sendfile.
+         */
+        void copyFilePartAsync(std::size_t written, std::size_t part, bool next);
+#endif
 
         /**
-         *  Reads and parses the head.
+         *  Drops the written response. Then either reads the next request or closes the connection.
          */
-        void readHead();
+        void finishWrite(boost::system::error_code const& ec, bool next);
+
+        /**
+         *  Sends the response of a threaded connection.
+         *  Held back while pipelined requests are already received.
+         *
+         *  @return true if the connection shall serve another request.
+         */
+        bool finishRequest();
+
+        /**
+         *  Skips the unread body and resets the request state.
+         *
+         *  @return true if the connection can serve another request.
+         */
+        bool prepareNext();
+
+        /**
+         *  Reads and drops whatever the handler did not read of the body.
+         *
+         *  @return true if the body is gone. Large bodies are not skipped.
+         */
+        bool discardBody();
+
+        /**
+         *  Sets the Connection header field. Turns keep-alive off, if the response does not
+         *  allow the client to find its end.
+         *
+         *  @param hasLength The Content-Length is written apart from the response fields.
+         */
+        void prepareHeader(ResponseHeader& response, bool hasLength = false);
+
+        /**
+         *  Returns the fields added to every response: Date and Server, see ServerSettings.
+         *  Fields the response sets itself are left out.
+         *
+         *  @param response The response header, nullptr for canned responses.
+         *
+         *  @param extraFields Lines put in front of the common fields.
+         *
+         *  @return Complete field lines, valid until the next call.
+         */
+        boost::string_view getCommonFields(ResponseHeader const* response, boost::string_view extraFields = {});
+
+        /**
+         *  Writes the header with the common fields into the output buffer.
+         *
+         *  @param extraFields Pre-serialized lines added to the response fields.
+         */
+        void writeHeader(ResponseHeader const& response, boost::string_view extraFields = {});
+
+        /**
+         *  Sends a file from the FileCache: The header and the contents go out with a single gather write,
+         *  together with whatever is pending in the output buffer.
+         *  Asynchronous connections queue the contents for writeAsync instead.
+         */
+        void sendCachedFile(std::string const& fileName, std::shared_ptr <CachedFile const> const& file, bool autoDetectContentType, ResponseHeader& response);
+
+        /**
+         *  Marks a file modification time that is not known.
+         */
+        static constexpr std::int64_t unknownModification = std::numeric_limits <std::int64_t>::min();
+
+        /**
+         *  Makes the validators of a file and answers a conditional request with them, see sendNotModified.
+         *
+         *  @param modified The modification time of the file in nanoseconds, or unknownModification.
+         *  @param validatorFields Receives the ETag and Last-Modified lines.
+         *         Stays empty if the time is unknown or the response sets either field itself.
+         *
+         *  @return true if the request was answered with 304 (Not Modified).
+         */
+        bool checkFileConditions(std::uint64_t size, std::int64_t modified, ResponseHeader& response, std::string& validatorFields);
+
+        /**
+         *  Answers a GET or HEAD request with 304 (Not Modified), if If-None-Match lists the entity tag or,
+         *  without If-None-Match, If-Modified-Since is not before the modification time (RFC 7232 6).
+         *
+         *  @param entityTag The tag of the file, empty to skip the check.
+         *  @param modified The modification time of the file in nanoseconds.
+         *  @param validatorFields The ETag and Last-Modified lines, repeated in the 304 response.
+         *
+         *  @return true if the 304 response was written.
+         */
+        bool sendNotModified(boost::string_view entityTag, std::int64_t modified, boost::string_view validatorFields, ResponseHeader& response);
+
+        /**
+         *  Answers a Range request for a file with 206 (Partial Content), as multipart/byteranges for several ranges,
+         *  or with 416 (Range Not Satisfiable). Honors If-Range against the modification time,
+         *  or against an ETag the response sets, as weak tags never match there.
+         *
+         *  @param modified The modification time of the file in nanoseconds, or unknownModification.
+         *  @param validatorFields The ETag and Last-Modified lines, added to the 206 response.
+         *  @param sendPart Sends length bytes of the file from offset.
+         *
+         *  @return false if the whole file is to be sent: There is no Range field, it is ignored or If-Range does not match.
+         *          Nothing is sent then.
+         */
+        bool sendFileRanges(std::string const& fileName, bool autoDetectContentType, std::uint64_t size, std::int64_t modified,
+                            boost::string_view validatorFields, ResponseHeader& response, std::function <void(std::uint64_t, std::uint64_t)> const& sendPart);
+
+        /**
+         *  Returns an empty stream for composing a body whose size must be known before sending it.
+         *  The memory is reused by later responses.
+         */
+        std::ostream& beginComposedBody();
+
+        /**
+         *  Sends the header and the body composed in the stream of beginComposedBody.
+         */
+        void sendComposedBody(ResponseHeader& response);
+
+        /**
+         *  Returns whether another complete request head has been received.
+         */
+        bool hasBufferedHead();
+
+        /**
+         *  Responses to HEAD requests must not contain a body.
+         */
+        bool isHeadRequest() const;
+
+        /**
+         *  Waits for data to become readable on the socket.
+         *
+         *  @return false on timeout.
+         */
+        bool waitReadable(std::chrono::milliseconds timeout);
+
+        /**
+         *  Waits for the socket to accept more data.
+         *
+         *  @return false on timeout.
+         */
+        bool waitWritable(std::chrono::milliseconds timeout);
+
+        /**
+         *  Writes the header for a file of the given size, see sendFile.
+         */
+        void writeFileHeader(std::string const& fileName, bool autoDetectContentType, std::uint64_t size, ResponseHeader& response,
+                             boost::string_view validatorFields = {});
+
+#ifndef _WIN32
+        /**
+         *  Sends a part of a file with sendfile (Linux), after writing out what is pending in the output buffer.
+         *  Turns keep-alive off if the part cannot be sent completely.
+         *  Asynchronous connections queue the part for writeAsync instead.
+         *
+         *  @param owner Keeps the descriptor open until a queued part is sent.
+         *
+         *  @return false if the client went away or the file is shorter than expected.
+         */
+        bool sendFileContent(int file, std::uint64_t offset, std::uint64_t length, std::shared_ptr <void const> const& owner);
+
+        /**
+         *  The same as sendFileContent, reading the file into the output buffer.
+         *  For file systems that do not support sendfile.
+         */
+        bool copyFileContent(int file, std::uint64_t offset, std::uint64_t length);
+#endif
+
+        /**
+         *  Closes the socket. Thread safe.
+         */
+        void close();
+
+        /**
+         *  Writes to the socket, blocking. Errors are swallowed like with any other stream,
+         *  a client that went away is not our problem.
+         */
+        void write(char const* data, std::size_t size);
 
         /**
          *  Closes the connection and removes it from the server list.
          */
         void free();
 
+        /**
+         *  Decodes the next piece of a chunked body.
+         */
+        boost::string_view decodeBodyChunk(std::chrono::milliseconds timeout);
+
+        /**
+         *  Waits for more of the body and appends it to input_.
+         *
+         *  @throw RequestTimeout, InvalidRequest
+         */
+        void receiveBody(std::chrono::milliseconds timeout);
+
         /**
          *  Sets the remote endpoint for access.
          */
         void setEndpoint(boost::asio::ip::tcp::acceptor::endpoint_type remote);
 
         /**
-         *  Internal function that reduces code duplication
+         *  A part of a file, sent by an asynchronous connection after the handler has returned. See writeAsync.
          */
-        void read(std::function <void(char const*, long)> writer, std::chrono::duration <long> const& timeout);
+        struct FilePart
+        {
+            std::size_t position; // the amount of buffered output in front of the part.
+            std::shared_ptr <void const> owner; // keeps the contents or the descriptor alive.
+            char const* contents; // cached contents, nullptr to send from the descriptor.
+            int descriptor;
+            std::uint64_t offset;
+            std::uint64_t length;
+        };
+
 
     private:
         RestServer* owner_;
         UserId id_;
-        boost::asio::ip::tcp::iostream stream_;
+        boost::asio::ip::tcp::socket socket_;
+        boost::asio::io_service::strand strand_; // serializes the completion handlers of asynchronous connections.
+        boost::asio::streambuf input_; // received but not yet consumed data.
+        OutputBuffer output_;
+        std::ostream stream_;
+        std::string body_; // see beginComposedBody.
+        StringBuffer bodyBuffer_;
+        std::ostream bodyStream_;
+        std::string commonFields_; // see getCommonFields.
         boost::asio::ip::tcp::acceptor::endpoint_type endpoint_;
+        std::size_t shard_;
+        bool asynchronous_;
+        boost::asio::steady_timer timer_; // idle timeout of asynchronous connections.
+        bool waitingForHead_; // true while an asynchronous connection is idle, or a threaded one waits in waitForHeadAsync.
+        bool headReadable_; // the socket became readable while waiting in waitForHeadAsync.
+        bool headTimedOut_; // the idle time ran out while waiting in waitForHeadAsync.
+        std::chrono::steady_clock::time_point headDeadline_; // end of the idle time of a threaded connection.
+        bool waitingForBody_; // true while an asynchronous connection reads the body ahead of the handler.
+        bool waitingForWrite_; // true while an asynchronous connection waits for room to send a file part.
+        std::vector <FilePart> fileParts_; // queued behind the output buffer by asynchronous connections.
+        std::vector <char> copyBuffer_; // see copyFilePartAsync.
+        bool keepAlive_; // whether the current request allows another one to follow.
+        bool responded_; // whether the handler sent a response through one of the send functions.
+        std::size_t requestCount_; // requests served so far.
+        std::size_t pipelined_; // responses held back for pipelined requests.
+        RequestParser parser_; // parses the head in place in input_.
+        std::size_t bodyRemaining_; // unread bytes of the current body.
+        std::size_t chunkSize_; // size of the body chunk last handed out by readBodyChunk, still in input_.
+        bool chunked_; // whether the body is sent with Transfer-Encoding: chunked.
+        ChunkedDecoder decoder_; // decodes chunked bodies in place in input_.
+        std::string head_; // the head of the current request, request_ points into it.
 
         RequestHeader request_;
+        std::unique_ptr <ChunkedWriter> chunkedWriter_; // the body stream of a response started with sendChunked.
     };
 
 } // namespace Rest
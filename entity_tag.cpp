@@ -0,0 +1,77 @@
+#include "entity_tag.hpp"
+#include "http_date.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <ctime>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        void appendHex(std::string& text, std::uint64_t value)
+        {
+            char digits[16];
+            std::size_t count = 0;
+            do {
+                digits[count++] = "0123456789abcdef"[value & 0xF];
+                value >>= 4;
+            } while (value != 0);
+            while (count != 0)
+                text.push_back(digits[--count]);
+        }
+
+        /**
+         *  Strips the weakness indicator, leaving the quoted opaque tag.
+         */
+        boost::string_view opaqueTag(boost::string_view tag)
+        {
+            if (boost::algorithm::starts_with(tag, "W/"))
+                tag.remove_prefix(2);
+            return tag;
+        }
+    }
+//#######################################################################################################
+    std::string makeFileEntityTag(std::uint64_t size, std::int64_t modified)
+    {
+        std::string tag = "W/\"";
+        appendHex(tag, size);
+        tag.push_back('-');
+        appendHex(tag, static_cast <std::uint64_t> (modified));
+        tag.push_back('"');
+        return tag;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::string makeFileValidatorFields(std::uint64_t size, std::int64_t modified)
+    {
+        return "ETag: " + makeFileEntityTag(size, modified) + "\r\n"
+            "Last-Modified: " + formatHttpDate(static_cast <std::time_t> (modified / 1000000000)) + "\r\n";
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool matchesEntityTag(boost::string_view list, boost::string_view tag)
+    {
+        tag = opaqueTag(tag);
+        for (;;)
+        {
+            while (!list.empty() && (list.front() == ' ' || list.front() == '\t' || list.front() == ','))
+                list.remove_prefix(1);
+            if (list.empty())
+                return false;
+            if (list.front() == '*')
+                return true;
+
+            // commas may appear inside the quotes, so the list is not just split at them.
+            list = opaqueTag(list);
+            if (list.empty() || list.front() != '"')
+                return false;
+            auto end = list.find('"', 1);
+            if (end == boost::string_view::npos)
+                return false;
+            if (list.substr(0, end + 1) == tag)
+                return true;
+            list.remove_prefix(end + 1);
+        }
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+#include <cstdint>
+
+namespace Rest {
+
+    /**
+     *  Makes a weak entity tag for a file from its size and modification time, W/"<size>-<modified>" in hex.
+     *  It changes whenever either does, without reading the contents.
+     *
+     *  @param modified The modification time in nanoseconds.
+     */
+    std::string makeFileEntityTag(std::uint64_t size, std::int64_t modified);
+
+    /**
+     *  Makes the ETag and Last-Modified field lines of a file, "ETag: ...\r\nLast-Modified: ...\r\n".
+     *
+     *  @param modified The modification time in nanoseconds.
+     */
+    std::string makeFileValidatorFields(std::uint64_t size, std::int64_t modified);
+
+    /**
+     *  Checks an If-None-Match value, a list of entity tags or "*", against a tag (RFC 7232 3.2).
+     *  Uses the weak comparison: W/"a" and "a" are the same.
+     *
+     *  @return true if the tag is listed. Broken values never match.
+     */
+    bool matchesEntityTag(boost::string_view list, boost::string_view tag);
+
+} // namespace Rest
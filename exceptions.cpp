@@ -14,8 +14,20 @@ namespace Rest
         return message_.c_str();
     }
 //-------------------------------------------------------------------------------------------------------
-    InvalidRequest::InvalidRequest(std::string message)
+    InvalidRequest::InvalidRequest(std::string message, int statusCode)
         : RestException(std::move(message))
+        , statusCode_(statusCode)
+    {
+
+    }
+//-------------------------------------------------------------------------------------------------------
+    int InvalidRequest::getStatusCode() const
+    {
+        return statusCode_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    RequestTimeout::RequestTimeout(std::string message)
+        : InvalidRequest(std::move(message), 408)
     {
 
     }
@@ -28,7 +28,28 @@ namespace Rest {
     class InvalidRequest : public RestException
     {
     public:
-        InvalidRequest(std::string message);
+        /**
+         *  @param statusCode The response code the client shall get, 400 (Bad Request) by default.
+         */
+        InvalidRequest(std::string message, int statusCode = 400);
+
+        /**
+         *  Returns the response code that fits the error.
+         */
+        int getStatusCode() const;
+
+    private:
+        int statusCode_;
+    };
+
+    /**
+     *  Thrown when the client does not send (the rest of) a request in time.
+     *  Answered with 408 (Request Timeout).
+     */
+    class RequestTimeout : public InvalidRequest
+    {
+    public:
+        RequestTimeout(std::string message);
     };
 
 } // namespace Rest
@@ -0,0 +1,246 @@
+#include "file_cache.hpp"
+#include "mime.hpp"
+#include "entity_tag.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#ifdef _WIN32
+#   include <fstream>
+#   include <sys/types.h>
+#   include <sys/stat.h>
+#else
+#   include <sys/types.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#endif
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        constexpr std::size_t maxShardCount = 16;
+        constexpr char acceptRangesField[] = "Accept-Ranges: bytes\r\n";
+
+        /**
+         *  As many shards as possible, as long as every shard can hold a file of the maximum size.
+         */
+        std::size_t countShards(std::size_t capacity, std::size_t maxFileSize)
+        {
+            if (maxFileSize == 0)
+                return maxShardCount;
+            return std::max <std::size_t> (1, std::min(maxShardCount, capacity / maxFileSize));
+        }
+
+        /**
+         *  @return false if the file does not exist or is not a regular file.
+         */
+        bool getStatus(std::string const& path, FileStatus& status)
+        {
+            status.checked = true;
+            status.exists = false;
+#ifdef _WIN32
+            struct _stat64 info;
+            if (_stat64(path.c_str(), &info) != 0 || (info.st_mode & _S_IFREG) == 0)
+                return false;
+            status.modified = static_cast <std::int64_t> (info.st_mtime) * 1000000000;
+#else
+            struct stat info;
+            if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+                return false;
+#   ifdef __APPLE__
+            status.modified = static_cast <std::int64_t> (info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#   else
+            status.modified = static_cast <std::int64_t> (info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#   endif
+#endif
+            status.size = static_cast <std::uint64_t> (info.st_size);
+            status.exists = true;
+            return true;
+        }
+
+        /**
+         *  Reads size bytes of a file.
+         *
+         *  @return false if the file cannot be read or is shorter.
+         */
+        bool readFile(std::string const& path, std::string& contents, std::size_t size)
+        {
+            contents.resize(size);
+#ifdef _WIN32
+            std::ifstream reader(path, std::ios_base::binary);
+            reader.read(&contents[0], static_cast <std::streamsize> (size));
+            return static_cast <std::size_t> (reader.gcount()) == size;
+#else
+            auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (file < 0)
+                return false;
+
+            std::size_t offset = 0;
+            while (offset != size)
+            {
+                auto got = ::read(file, &contents[offset], size - offset);
+                if (got < 0 && errno == EINTR)
+                    continue;
+                if (got <= 0)
+                    break;
+                offset += static_cast <std::size_t> (got);
+            }
+            ::close(file);
+            return offset == size;
+#endif
+        }
+    }
+//#######################################################################################################
+    boost::string_view CachedFile::getFields(bool withType) const
+    {
+        boost::string_view all {fields};
+        return withType ? all : all.substr(typeFieldSize);
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view CachedFile::getValidatorFields() const
+    {
+        return boost::string_view{fields}.substr(typeFieldSize, validatorFieldsSize);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::string CachedFile::composeFields(bool withType, bool withValidators, bool withAcceptRanges) const
+    {
+        auto acceptRanges = typeFieldSize + validatorFieldsSize;
+        auto length = acceptRanges + sizeof(acceptRangesField) - 1;
+
+        std::string composed;
+        if (withType)
+            composed.append(fields, 0, typeFieldSize);
+        if (withValidators)
+            composed.append(fields, typeFieldSize, validatorFieldsSize);
+        if (withAcceptRanges)
+            composed.append(fields, acceptRanges, length - acceptRanges);
+        composed.append(fields, length, std::string::npos);
+        return composed;
+    }
+//#######################################################################################################
+    FileCache::FileCache(std::size_t capacity, std::size_t maxFileSize)
+        : shardCapacity_(capacity / countShards(capacity, maxFileSize))
+        , maxFileSize_(std::min(maxFileSize, shardCapacity_))
+        , shards_()
+    {
+        for (std::size_t i = 0, count = countShards(capacity, maxFileSize); i != count; ++i)
+            shards_.emplace_back(new Shard);
+    }
+//-------------------------------------------------------------------------------------------------------
+    FileCache::Shard& FileCache::getShard(std::string const& path)
+    {
+        return *shards_[std::hash <std::string>{}(path) % shards_.size()];
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::shared_ptr <CachedFile const> FileCache::get(std::string const& path, FileStatus* found)
+    {
+        auto& shard = getShard(path);
+        auto now = std::time(nullptr);
+
+        std::shared_ptr <CachedFile const> known;
+        {
+            std::lock_guard <std::mutex> guard {shard.lock};
+            auto entry = shard.entries.find(path);
+            if (entry != std::end(shard.entries))
+            {
+                shard.order.splice(std::begin(shard.order), shard.order, entry->second.position);
+                if (entry->second.checked == now)
+                    return entry->second.file;
+                known = entry->second.file;
+            }
+        }
+
+        // the disk is looked at without holding the lock.
+        FileStatus status;
+        auto cacheable = getStatus(path, status) && status.size != 0 && status.size <= maxFileSize_;
+        if (found)
+            *found = status;
+        if (cacheable && known && known->modified == status.modified && known->contents.size() == status.size)
+        {
+            std::lock_guard <std::mutex> guard {shard.lock};
+            auto entry = shard.entries.find(path);
+            if (entry != std::end(shard.entries) && entry->second.file == known)
+                entry->second.checked = now;
+            return known;
+        }
+
+        std::shared_ptr <CachedFile> file;
+        if (cacheable)
+        {
+            file = std::make_shared <CachedFile> ();
+            if (readFile(path, file->contents, static_cast <std::size_t> (status.size)))
+            {
+                auto type = extensionToMimeType(extractFileExtension(path));
+                if (!type.empty())
+                    file->fields = "Content-Type: " + type + "\r\n";
+                file->typeFieldSize = file->fields.size();
+                file->fields += makeFileValidatorFields(status.size, status.modified);
+                file->validatorFieldsSize = file->fields.size() - file->typeFieldSize;
+                file->entityTag = makeFileEntityTag(status.size, status.modified);
+                file->fields += acceptRangesField;
+                file->fields += "Content-Length: " + std::to_string(file->contents.size()) + "\r\n";
+                file->modified = status.modified;
+            }
+            else
+                file.reset();
+        }
+
+        std::lock_guard <std::mutex> guard {shard.lock};
+        if (file)
+            insert(shard, path, file, now);
+        else
+        {
+            auto entry = shard.entries.find(path);
+            if (entry != std::end(shard.entries))
+                erase(shard, entry);
+        }
+        return file;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void FileCache::insert(Shard& shard, std::string const& path, std::shared_ptr <CachedFile const> file, std::time_t now)
+    {
+        auto entry = shard.entries.find(path);
+        if (entry != std::end(shard.entries))
+            erase(shard, entry);
+
+        shard.size += file->contents.size();
+        shard.order.push_front(path);
+        shard.entries.emplace(path, Entry {std::move(file), now, std::begin(shard.order)});
+
+        while (shard.size > shardCapacity_ && !shard.order.empty())
+            erase(shard, shard.entries.find(shard.order.back()));
+    }
+//-------------------------------------------------------------------------------------------------------
+    void FileCache::erase(Shard& shard, std::unordered_map <std::string, Entry>::iterator entry)
+    {
+        shard.size -= entry->second.file->contents.size();
+        shard.order.erase(entry->second.position);
+        shard.entries.erase(entry);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void FileCache::invalidate(std::string const& path)
+    {
+        auto& shard = getShard(path);
+        std::lock_guard <std::mutex> guard {shard.lock};
+        auto entry = shard.entries.find(path);
+        if (entry != std::end(shard.entries))
+            erase(shard, entry);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void FileCache::clear()
+    {
+        for (auto& shard : shards_)
+        {
+            std::lock_guard <std::mutex> guard {shard->lock};
+            shard->entries.clear();
+            shard->order.clear();
+            shard->size = 0;
+        }
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+
+namespace Rest {
+
+    /**
+     *  A file held in memory by the FileCache.
+     */
+    struct CachedFile
+    {
+        std::string contents;
+        std::string fields; // "Content-Type: ...\r\nETag: ...\r\nLast-Modified: ...\r\nAccept-Ranges: bytes\r\nContent-Length: ...\r\n", the type only if it is known.
+        std::size_t typeFieldSize; // the size of the Content-Type line at the front of fields, 0 if there is none.
+        std::size_t validatorFieldsSize; // the size of the ETag and Last-Modified lines behind the type.
+        std::string entityTag;
+        std::int64_t modified; // modification time in nanoseconds, to notice changes.
+
+        /**
+         *  Returns the pre-serialized fields.
+         *
+         *  @param withType Includes the Content-Type line.
+         */
+        boost::string_view getFields(bool withType) const;
+
+        /**
+         *  Returns the ETag and Last-Modified lines, for responses without the whole file.
+         */
+        boost::string_view getValidatorFields() const;
+
+        /**
+         *  Copies the fields, leaving out those the response sets itself. The fast path is getFields.
+         */
+        std::string composeFields(bool withType, bool withValidators, bool withAcceptRanges) const;
+    };
+
+    /**
+     *  What FileCache::get found on the disk, so that a miss does not need to look again.
+     */
+    struct FileStatus
+    {
+        bool checked = false; // the disk was looked at. Not the case for files served from memory within the same second.
+        bool exists = false; // there is a regular file.
+        std::uint64_t size = 0;
+        std::int64_t modified = 0; // in nanoseconds.
+    };
+
+    /**
+     *  Keeps the contents of recently sent files in memory, with the header fields that only depend on the file.
+     *  The cache is split into shards by path, each with its own lock and least recently used order,
+     *  so that threads sending different files rarely wait for each other. There are up to 16 shards,
+     *  fewer if the capacity would not leave room for a file of the maximum size in each.
+     *  Files are checked for changes (modification time and size) at most once per second.
+     */
+    class FileCache
+    {
+    public:
+        /**
+         *  @param capacity The maximum amount of bytes of all cached contents together.
+         *  @param maxFileSize Larger files are not cached. Limited to the capacity.
+         */
+        FileCache(std::size_t capacity, std::size_t maxFileSize);
+
+        /**
+         *  Returns a file, reading it into the cache if it is not there or has changed.
+         *  The returned file stays valid when it is evicted meanwhile.
+         *
+         *  @param found Receives what was found on the disk, if it was looked at.
+         *
+         *  @return nullptr if the file is not cached: It is missing, not a regular file, empty or too large.
+         */
+        std::shared_ptr <CachedFile const> get(std::string const& path, FileStatus* found = nullptr);
+
+        /**
+         *  Drops a file, for instance after changing it within the same second.
+         */
+        void invalidate(std::string const& path);
+
+        /**
+         *  Drops all files.
+         */
+        void clear();
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr <CachedFile const> file;
+            std::time_t checked; // the second the file was last compared with the disk.
+            std::list <std::string>::iterator position; // in Shard::order
+        };
+
+        struct Shard
+        {
+            std::mutex lock;
+            std::list <std::string> order; // most recently used first.
+            std::unordered_map <std::string, Entry> entries;
+            std::size_t size = 0; // of all contents.
+        };
+
+        Shard& getShard(std::string const& path);
+
+        /**
+         *  Adds or replaces an entry and evicts the least recently used ones beyond the capacity. Requires shard.lock.
+         */
+        void insert(Shard& shard, std::string const& path, std::shared_ptr <CachedFile const> file, std::time_t now);
+
+        /**
+         *  Removes an entry. Requires shard.lock.
+         */
+        void erase(Shard& shard, std::unordered_map <std::string, Entry>::iterator entry);
+
+    private:
+        std::size_t shardCapacity_;
+        std::size_t maxFileSize_;
+        std::vector <std::unique_ptr <Shard>> shards_;
+    };
+
+} // namespace Rest
@@ -0,0 +1,173 @@
+#include "http_date.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        constexpr std::size_t wordCount = (dateLineSize + 7) / 8;
+
+        /**
+         *  The published line. Words instead of chars, so that readers copy it with few atomic loads.
+         *  An odd sequence means the line is being written.
+         */
+        struct DateCache
+        {
+            std::atomic <std::uint64_t> words[wordCount];
+            std::atomic <unsigned> sequence;
+            std::atomic <std::time_t> second; // the second the line was formatted for.
+            std::atomic <bool> updating;
+        };
+
+        DateCache cache {{}, {0}, {-1}, {false}};
+
+        void put2(char* out, int value)
+        {
+            out[0] = static_cast <char> ('0' + value / 10);
+            out[1] = static_cast <char> ('0' + value % 10);
+        }
+
+        /**
+         *  IMF-fixdate (RFC 7231), without strftime, which depends on the locale.
+         */
+        void formatDateLine(std::time_t now, char* line)
+        {
+            static char const days[] = "SunMonTueWedThuFriSat";
+            static char const months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+            std::tm time;
+#ifdef _WIN32
+            gmtime_s(&time, &now);
+#else
+            gmtime_r(&now, &time);
+#endif
+
+            std::memcpy(line, "Date: Sun, 00 Jan 0000 00:00:00 GMT\r\n", dateLineSize);
+            std::memcpy(line + 6, days + 3 * time.tm_wday, 3);
+            put2(line + 11, time.tm_mday);
+            std::memcpy(line + 14, months + 3 * time.tm_mon, 3);
+            auto year = time.tm_year + 1900;
+            put2(line + 18, year / 100);
+            put2(line + 20, year % 100);
+            put2(line + 23, time.tm_hour);
+            put2(line + 26, time.tm_min);
+            put2(line + 29, time.tm_sec);
+        }
+
+        /**
+         *  @return -1 if the text is not two digits.
+         */
+        int get2(char const* in)
+        {
+            if (in[0] < '0' || in[0] > '9' || in[1] < '0' || in[1] > '9')
+                return -1;
+            return (in[0] - '0') * 10 + (in[1] - '0');
+        }
+
+        /**
+         *  Days since 1970-01-01 of a date in the proleptic Gregorian calendar, without timegm, which is not portable.
+         */
+        std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day)
+        {
+            year -= month <= 2;
+            auto era = (year >= 0 ? year : year - 399) / 400;
+            auto yearOfEra = static_cast <unsigned> (year - era * 400);
+            auto dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            auto dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097 + static_cast <std::int64_t> (dayOfEra) - 719468;
+        }
+
+        void refresh(std::time_t now)
+        {
+            // one thread formats, the others keep using the previous line meanwhile.
+            auto expected = false;
+            if (!cache.updating.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return;
+
+            if (cache.second.load(std::memory_order_relaxed) != now)
+            {
+                std::uint64_t words[wordCount] = {};
+                formatDateLine(now, reinterpret_cast <char*> (words));
+
+                auto sequence = cache.sequence.load(std::memory_order_relaxed);
+                cache.sequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (std::size_t i = 0; i != wordCount; ++i)
+                    cache.words[i].store(words[i], std::memory_order_relaxed);
+                cache.sequence.store(sequence + 2, std::memory_order_release);
+                cache.second.store(now, std::memory_order_relaxed);
+            }
+
+            cache.updating.store(false, std::memory_order_release);
+        }
+    }
+//#######################################################################################################
+    void getDateLine(char (&line)[dateLineSize])
+    {
+        auto now = std::time(nullptr);
+        if (cache.second.load(std::memory_order_relaxed) != now)
+            refresh(now);
+
+        std::uint64_t words[wordCount];
+        for (;;)
+        {
+            // 0 means nothing was published yet, the first refresh is still running.
+            auto before = cache.sequence.load(std::memory_order_acquire);
+            if (before == 0 || (before & 1) != 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (std::size_t i = 0; i != wordCount; ++i)
+                words[i] = cache.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (cache.sequence.load(std::memory_order_relaxed) == before)
+                break;
+        }
+        std::memcpy(line, words, dateLineSize);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::string formatHttpDate(std::time_t time)
+    {
+        char line[dateLineSize];
+        formatDateLine(time, line);
+
+        // without "Date: " and the line break.
+        return {line + 6, dateLineSize - 8};
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool parseHttpDate(boost::string_view value, std::time_t& time)
+    {
+        static char const months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+        // "Sun, 06 Nov 1994 08:49:37 GMT", the weekday is not checked.
+        if (value.size() != 29 || value.substr(3, 2) != ", " || value[7] != ' ' || value[11] != ' ' ||
+            value[16] != ' ' || value[19] != ':' || value[22] != ':' || value.substr(25) != " GMT")
+            return false;
+
+        auto month = boost::string_view{months}.find(value.substr(8, 3));
+        auto day = get2(value.data() + 5);
+        auto century = get2(value.data() + 12);
+        auto year = get2(value.data() + 14);
+        auto hour = get2(value.data() + 17);
+        auto minute = get2(value.data() + 20);
+        auto second = get2(value.data() + 23);
+        if (month == boost::string_view::npos || month % 3 != 0 || day < 1 || day > 31 || century < 0 || year < 0 ||
+            hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60)
+            return false;
+
+        auto days = daysFromCivil(century * 100 + year, static_cast <unsigned> (month / 3 + 1), static_cast <unsigned> (day));
+        time = static_cast <std::time_t> (days * 86400 + hour * 3600 + minute * 60 + second);
+        return true;
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+#include <cstddef>
+#include <ctime>
+
+namespace Rest {
+
+    /**
+     *  Size of a Date header line, "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n".
+     */
+    constexpr std::size_t dateLineSize = 37;
+
+    /**
+     *  Copies the Date header line for the current second.
+     *  The line is formatted by the first caller in a new second and shared with all threads through a seqlock,
+     *  so other callers only copy it.
+     *
+     *  @param line Receives the line, which is not null terminated.
+     */
+    void getDateLine(char (&line)[dateLineSize]);
+
+    /**
+     *  Formats a point in time like the Date field, "Sun, 06 Nov 1994 08:49:37 GMT".
+     *  For fields such as Last-Modified.
+     */
+    std::string formatHttpDate(std::time_t time);
+
+    /**
+     *  Parses an IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT", as sent in If-Modified-Since.
+     *  The obsolete RFC 850 and asctime formats are not understood.
+     *
+     *  @return false if the value is not such a date.
+     */
+    bool parseHttpDate(boost::string_view value, std::time_t& time);
+
+} // namespace Rest
@@ -1,10 +1,25 @@
 #include "io_service_provider.hpp"
 
+#include <algorithm>
+
 namespace Rest {
 
     IOServiceProvider::IOServiceProvider()
         : ioService()
+        , threadLock_()
+        , work_(nullptr)
+        , threads_()
+        , users_(0)
+    {
+    }
+
+    IOServiceProvider::~IOServiceProvider()
     {
+        std::lock_guard <std::mutex> guard (threadLock_);
+        work_.reset();
+        ioService.stop();
+        for (auto& thread : threads_)
+            thread.join();
     }
 
     boost::asio::io_service& IOServiceProvider::getIOService()
@@ -12,4 +27,31 @@ namespace Rest {
         return ioService;
     }
 
+    void IOServiceProvider::acquireThreads(std::size_t threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+        std::lock_guard <std::mutex> guard (threadLock_);
+        ++users_;
+        if (!work_)
+            work_.reset(new boost::asio::io_service::work(ioService));
+        while (threads_.size() < threadCount)
+            threads_.emplace_back([this]() { ioService.run(); });
+    }
+
+    void IOServiceProvider::releaseThreads()
+    {
+        std::lock_guard <std::mutex> guard (threadLock_);
+        if (users_ == 0 || --users_ != 0)
+            return;
+
+        // let the threads finish all outstanding handlers.
+        work_.reset();
+        for (auto& thread : threads_)
+            thread.join();
+        threads_.clear();
+        ioService.restart();
+    }
+
 }
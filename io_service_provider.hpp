@@ -1,6 +1,10 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <cstddef>
 #include <boost/asio.hpp>
 
 namespace Rest {
@@ -10,13 +14,13 @@ namespace Rest {
      *  The io service used is a global variable and therefore
      *  wrapped in a singleton.
      *
-     *  This class might provide thread pooling in the future.
+     *  Also owns the threads that run the io service.
      */
     class IOServiceProvider
     {
     public:
         // concopyable
-        ~IOServiceProvider() = default;
+        ~IOServiceProvider();
         IOServiceProvider(IOServiceProvider const&) = delete;
         IOServiceProvider& operator=(IOServiceProvider const&) = delete;
 
@@ -33,10 +37,29 @@ namespace Rest {
          */
         boost::asio::io_service& getIOService();
 
+        /**
+         *  Makes sure that at least threadCount threads are calling run() on the io service.
+         *  Every call must be paired with a call to releaseThreads.
+         *
+         *  @param threadCount Minimum amount of threads. 0 picks std::thread::hardware_concurrency().
+         */
+        void acquireThreads(std::size_t threadCount);
+
+        /**
+         *  Gives up the threads requested by acquireThreads.
+         *  The last user lets the threads run out of work and joins them.
+         *  Must not be called from one of the io service threads.
+         */
+        void releaseThreads();
+
     private:
         IOServiceProvider(); // not constructible
         boost::asio::io_service ioService; // io_service
+
+        std::mutex threadLock_; // protects the members below.
+        std::unique_ptr <boost::asio::io_service::work> work_; // keeps run() from returning while there are users.
+        std::vector <std::thread> threads_; // threads calling run().
+        std::size_t users_; // amount of acquireThreads calls not yet released.
     };
 
 } // namespace Rest
-
@@ -13,4 +13,10 @@ namespace Rest {
      */
     std::string extensionToMimeType(std::string const& extension);
 
+    /**
+     *  Returns the extension of a file name including the dot, "" if there is none.
+     *  "/www/app.js" => ".js"
+     */
+    std::string extractFileExtension(std::string const& fileName);
+
 } // namespace Rest
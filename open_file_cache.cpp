@@ -0,0 +1,159 @@
+#include "open_file_cache.hpp"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        constexpr std::size_t shardCount = 16;
+
+        std::int64_t getModified(struct stat const& info)
+        {
+#   ifdef __APPLE__
+            return static_cast <std::int64_t> (info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#   else
+            return static_cast <std::int64_t> (info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#   endif
+        }
+    }
+//#######################################################################################################
+    OpenFile::OpenFile(int descriptor, std::uint64_t size, std::int64_t modified, std::uint64_t device, std::uint64_t inode)
+        : descriptor_(descriptor)
+        , size_(size)
+        , modified_(modified)
+        , device_(device)
+        , inode_(inode)
+    {
+
+    }
+//-------------------------------------------------------------------------------------------------------
+    OpenFile::~OpenFile()
+    {
+        ::close(descriptor_);
+    }
+//-------------------------------------------------------------------------------------------------------
+    int OpenFile::getDescriptor() const
+    {
+        return descriptor_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::uint64_t OpenFile::getSize() const
+    {
+        return size_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::int64_t OpenFile::getModified() const
+    {
+        return modified_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool OpenFile::isSameAs(std::uint64_t size, std::int64_t modified, std::uint64_t device, std::uint64_t inode) const
+    {
+        return size_ == size && modified_ == modified && device_ == device && inode_ == inode;
+    }
+//#######################################################################################################
+    OpenFileCache::OpenFileCache(std::size_t capacity)
+        : shardCapacity_(std::max(capacity / shardCount, static_cast <std::size_t> (1u)))
+        , shards_()
+    {
+        for (std::size_t i = 0; i != shardCount; ++i)
+            shards_.emplace_back(new Shard);
+    }
+//-------------------------------------------------------------------------------------------------------
+    OpenFileCache::Shard& OpenFileCache::getShard(std::string const& path)
+    {
+        return *shards_[std::hash <std::string>{}(path) % shards_.size()];
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::shared_ptr <OpenFile const> OpenFileCache::get(std::string const& path)
+    {
+        auto& shard = getShard(path);
+        auto now = std::time(nullptr);
+
+        std::shared_ptr <OpenFile const> known;
+        {
+            std::lock_guard <std::mutex> guard {shard.lock};
+            auto entry = shard.entries.find(path);
+            if (entry != std::end(shard.entries))
+            {
+                shard.order.splice(std::begin(shard.order), shard.order, entry->second.position);
+                if (entry->second.checked == now)
+                    return entry->second.file;
+                known = entry->second.file;
+            }
+        }
+
+        // the disk is looked at without holding the lock.
+        struct stat info;
+        auto exists = ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+        if (exists && known && known->isSameAs(static_cast <std::uint64_t> (info.st_size), getModified(info), info.st_dev, info.st_ino))
+        {
+            std::lock_guard <std::mutex> guard {shard.lock};
+            auto entry = shard.entries.find(path);
+            if (entry != std::end(shard.entries) && entry->second.file == known)
+                entry->second.checked = now;
+            return known;
+        }
+
+        std::shared_ptr <OpenFile const> file;
+        if (exists)
+        {
+            auto descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (descriptor >= 0)
+            {
+                // the file may have been replaced after the stat above, so the descriptor is asked.
+                if (::fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode))
+                    file = std::make_shared <OpenFile> (descriptor, static_cast <std::uint64_t> (info.st_size), getModified(info), info.st_dev, info.st_ino);
+                else
+                    ::close(descriptor);
+            }
+        }
+
+        std::lock_guard <std::mutex> guard {shard.lock};
+        auto entry = shard.entries.find(path);
+        if (entry != std::end(shard.entries))
+        {
+            shard.order.erase(entry->second.position);
+            shard.entries.erase(entry);
+        }
+        if (file)
+            insert(shard, path, file, now);
+        return file;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void OpenFileCache::insert(Shard& shard, std::string const& path, std::shared_ptr <OpenFile const> file, std::time_t now)
+    {
+        shard.order.push_front(path);
+        shard.entries.emplace(path, Entry {std::move(file), now, std::begin(shard.order)});
+
+        while (shard.entries.size() > shardCapacity_)
+        {
+            shard.entries.erase(shard.order.back());
+            shard.order.pop_back();
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    void OpenFileCache::clear()
+    {
+        for (auto& shard : shards_)
+        {
+            std::lock_guard <std::mutex> guard {shard->lock};
+            shard->entries.clear();
+            shard->order.clear();
+        }
+    }
+//#######################################################################################################
+} // namespace Rest
+
+#endif // _WIN32
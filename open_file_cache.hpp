@@ -0,0 +1,102 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+
+namespace Rest {
+
+    /**
+     *  An open file with the results of stat, held by the OpenFileCache.
+     *  The descriptor is closed when the last holder lets go.
+     */
+    class OpenFile
+    {
+    public:
+        OpenFile(int descriptor, std::uint64_t size, std::int64_t modified, std::uint64_t device, std::uint64_t inode);
+        ~OpenFile();
+
+        OpenFile(OpenFile const&) = delete;
+        OpenFile& operator=(OpenFile const&) = delete;
+
+        int getDescriptor() const;
+        std::uint64_t getSize() const;
+
+        /**
+         *  Returns the modification time in nanoseconds since the epoch.
+         */
+        std::int64_t getModified() const;
+
+        /**
+         *  Returns whether the file at a path is still this file, unchanged.
+         */
+        bool isSameAs(std::uint64_t size, std::int64_t modified, std::uint64_t device, std::uint64_t inode) const;
+
+    private:
+        int descriptor_;
+        std::uint64_t size_;
+        std::int64_t modified_;
+        std::uint64_t device_;
+        std::uint64_t inode_;
+    };
+
+    /**
+     *  Keeps recently used files open, so that serving them again needs neither open nor fstat.
+     *  Sharded by path like the FileCache, bounded by the amount of open files.
+     *  A path is stat'ed again at most once per second, a replaced or changed file is reopened.
+     *  Not available on Windows.
+     */
+    class OpenFileCache
+    {
+    public:
+        /**
+         *  @param capacity The maximum amount of files kept open.
+         */
+        explicit OpenFileCache(std::size_t capacity);
+
+        /**
+         *  Returns an open regular file.
+         *
+         *  @return nullptr if there is no regular file at the path, or it cannot be opened.
+         */
+        std::shared_ptr <OpenFile const> get(std::string const& path);
+
+        /**
+         *  Closes all files, once they are not in use anymore.
+         */
+        void clear();
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr <OpenFile const> file;
+            std::time_t checked; // the second the path was last stat'ed.
+            std::list <std::string>::iterator position; // in Shard::order
+        };
+
+        struct Shard
+        {
+            std::mutex lock;
+            std::list <std::string> order; // most recently used first.
+            std::unordered_map <std::string, Entry> entries;
+        };
+
+        Shard& getShard(std::string const& path);
+
+        /**
+         *  Adds or replaces an entry and evicts the least recently used ones beyond the capacity. Requires shard.lock.
+         */
+        void insert(Shard& shard, std::string const& path, std::shared_ptr <OpenFile const> file, std::time_t now);
+
+    private:
+        std::size_t shardCapacity_;
+        std::vector <std::unique_ptr <Shard>> shards_;
+    };
+
+} // namespace Rest
@@ -0,0 +1,130 @@
+#include "output_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Rest
+{
+//#######################################################################################################
+    OutputBuffer::OutputBuffer(std::function <void(char const*, std::size_t)> writer, std::size_t threshold)
+        : buffer_()
+        , writer_(std::move(writer))
+        , threshold_(std::max(threshold, static_cast <std::size_t> (1024u)))
+        , deferred_(false)
+    {
+        setp(nullptr, nullptr);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void OutputBuffer::setDeferred(bool deferred)
+    {
+        deferred_ = deferred;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void OutputBuffer::commit()
+    {
+        if (size() != 0)
+            writer_(data(), size());
+        clear();
+    }
+//-------------------------------------------------------------------------------------------------------
+    char const* OutputBuffer::data() const
+    {
+        return pbase();
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t OutputBuffer::size() const
+    {
+        return static_cast <std::size_t> (pptr() - pbase());
+    }
+//-------------------------------------------------------------------------------------------------------
+    void OutputBuffer::clear()
+    {
+        if (buffer_.size() > threshold_)
+        {
+            std::vector <char> (threshold_).swap(buffer_);
+            setp(buffer_.data(), buffer_.data() + buffer_.size());
+            return;
+        }
+        setp(pbase(), epptr());
+    }
+//-------------------------------------------------------------------------------------------------------
+    void OutputBuffer::resize(std::size_t size)
+    {
+        auto pending = this->size();
+        buffer_.resize(size);
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+        pbump(static_cast <int> (pending));
+    }
+//-------------------------------------------------------------------------------------------------------
+    OutputBuffer::int_type OutputBuffer::overflow(int_type ch)
+    {
+        if (deferred_)
+            resize(std::max(buffer_.size() * 2, static_cast <std::size_t> (1024u)));
+        else if (buffer_.size() < threshold_)
+            resize(std::min(threshold_, std::max(buffer_.size() * 2, static_cast <std::size_t> (1024u))));
+        else
+            commit();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::streamsize OutputBuffer::xsputn(char_type const* data, std::streamsize count)
+    {
+        auto amount = static_cast <std::size_t> (count);
+        if (deferred_)
+        {
+            if (size() + amount > buffer_.size())
+                resize(std::max(size() + amount, buffer_.size() * 2));
+        }
+        else if (size() + amount > threshold_)
+        {
+            commit();
+
+            // large pieces go straight to the socket, there is no point in copying them first.
+            if (amount >= threshold_)
+            {
+                writer_(data, amount);
+                return count;
+            }
+        }
+
+        if (size() + amount > buffer_.size())
+            resize(std::min(threshold_, std::max(size() + amount, buffer_.size() * 2)));
+
+        std::memcpy(pptr(), data, amount);
+        pbump(static_cast <int> (amount));
+        return count;
+    }
+//-------------------------------------------------------------------------------------------------------
+    int OutputBuffer::sync()
+    {
+        if (!deferred_)
+            commit();
+        return 0;
+    }
+//#######################################################################################################
+    StringBuffer::StringBuffer(std::string& target)
+        : target_(&target)
+    {
+
+    }
+//-------------------------------------------------------------------------------------------------------
+    StringBuffer::int_type StringBuffer::overflow(int_type ch)
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            target_->push_back(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::streamsize StringBuffer::xsputn(char_type const* data, std::streamsize count)
+    {
+        target_->append(data, static_cast <std::size_t> (count));
+        return count;
+    }
+//#######################################################################################################
+} // namespace Rest
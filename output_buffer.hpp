@@ -0,0 +1,87 @@
+#pragma once
+
+#include <streambuf>
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  The stream buffer behind RestConnection::getStream.
+     *  Collects everything written to the connection and passes it to the socket in large pieces.
+     *  The buffer grows on demand up to the threshold, so idle connections stay small.
+     */
+    class OutputBuffer : public std::streambuf
+    {
+    public:
+        /**
+         *  @param writer Writes data to the socket. Blocks until everything is written.
+         *  @param threshold Pending data is written as soon as it reaches this size.
+         */
+        OutputBuffer(std::function <void(char const*, std::size_t)> writer, std::size_t threshold = 65536);
+
+        /**
+         *  A deferred buffer keeps its data on flush (pubsync) and grows beyond the threshold, it never writes by itself.
+         *  Used by asynchronous connections, which write the response once the handler returns.
+         */
+        void setDeferred(bool deferred);
+
+        /**
+         *  Writes all pending data now, regardless of deferral.
+         */
+        void commit();
+
+        /**
+         *  Returns the pending data.
+         */
+        char const* data() const;
+
+        /**
+         *  Returns the amount of pending bytes.
+         */
+        std::size_t size() const;
+
+        /**
+         *  Drops the pending data, for instance after it has been written asynchronously.
+         *  A buffer that has grown beyond the threshold is shrunk back.
+         */
+        void clear();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(char_type const* data, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        /**
+         *  Resizes the buffer and resets the put area, keeping the pending data.
+         */
+        void resize(std::size_t size);
+
+    private:
+        std::vector <char> buffer_;
+        std::function <void(char const*, std::size_t)> writer_;
+        std::size_t threshold_;
+        bool deferred_;
+    };
+
+    /**
+     *  A stream buffer appending to a string.
+     *  Lets a body be composed in a reused string, so that its size is known before the header is written.
+     */
+    class StringBuffer : public std::streambuf
+    {
+    public:
+        explicit StringBuffer(std::string& target);
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(char_type const* data, std::streamsize count) override;
+
+    private:
+        std::string* target_;
+    };
+
+} // namespace Rest
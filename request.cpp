@@ -3,23 +3,44 @@
 namespace Rest {
 //#######################################################################################################
     Request::Request(std::shared_ptr <RestConnection>& connection,
-                     std::unordered_map <std::string, std::string> parameters,
-                     Url url)
+                     boost::intrusive_ptr <SnapshotBase const> routes,
+                     std::vector <std::string> const& parameterNames,
+                     Router::Match const& match,
+                     UrlView target)
         : connection_(connection)
-        , parameters_(std::move(parameters))
-        , url_(std::move(url))
+        , routes_(std::move(routes))
+        , parameterNames_(&parameterNames)
+        , match_(match)
+        , target_(target)
+        , queryParameters_()
+        , queryDecoded_(false)
     {
 
     }
 //-------------------------------------------------------------------------------------------------------
     std::string Request::getUrl() const
     {
-        return connection_->getRequestHeader().url;
+        return connection_->getRequestHeader().url.to_string();
     }
 //-------------------------------------------------------------------------------------------------------
     std::unordered_map <std::string, std::string> Request::getQuery() const
     {
-        return url_.query;
+        // the first value of repeated keys wins.
+        std::unordered_map <std::string, std::string> query;
+        for (auto const& parameter : getQueryParameters())
+            query.emplace(parameter.first, parameter.second);
+        return query;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::vector <std::pair <std::string, std::string>> const& Request::getQueryParameters() const
+    {
+        // the encoding was checked while routing.
+        if (!queryDecoded_)
+        {
+            ReducedUrlParser::decodeQuery(target_.query, queryParameters_);
+            queryDecoded_ = true;
+        }
+        return queryParameters_;
     }
 //-------------------------------------------------------------------------------------------------------
     bool Request::isSecure() const
@@ -29,12 +50,31 @@ namespace Rest {
 //-------------------------------------------------------------------------------------------------------
     std::string Request::getPath() const
     {
-        return url_.path;
+        return target_.path.to_string();
     }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t Request::findParameter(std::string const& id) const
+    {
+        std::size_t index = 0;
+        for (; index != match_.parameterCount; ++index)
+        {
+            if ((*parameterNames_)[index] == id)
+                break;
+        }
+        return index;
+    }
 //-------------------------------------------------------------------------------------------------------
     std::string Request::getParameter(std::string const& id)
     {
-        return parameters_[id];
+        return getParameterView(id).to_string();
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view Request::getParameterView(std::string const& id) const
+    {
+        auto index = findParameter(id);
+        if (index == match_.parameterCount)
+            return {};
+        return match_.parameters[index];
     }
 //-------------------------------------------------------------------------------------------------------
     std::string Request::param(std::string const& id)
@@ -52,16 +92,45 @@ namespace Rest {
         return getRemoteAddress();
     }
 //-------------------------------------------------------------------------------------------------------
-    std::string Request::getHeaderField(std::string const& key)
+    std::string Request::getHeaderField(std::string const& key) const
     {
-        // it does not hurt to add it if nonexistant, because it will be empty
-        return connection_->getRequestHeader().entries[key];
+        return connection_->getHeaderField(key).to_string();
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view Request::getHeaderView(boost::string_view key) const
+    {
+        return connection_->getHeaderField(key);
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view Request::getHeaderView(KnownHeader header) const
+    {
+        return connection_->getHeaderField(header);
+    }
+//-------------------------------------------------------------------------------------------------------
+    RequestHeader const& Request::getRequestHeader() const
+    {
+        return connection_->getRequestHeader();
     }
 //-------------------------------------------------------------------------------------------------------
     std::string Request::getString()
     {
         return connection_->readString();
     }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t Request::readBody(std::function <void(boost::string_view)> const& onData)
+    {
+        return connection_->readBody(onData);
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view Request::readBodyChunk()
+    {
+        return connection_->readBodyChunk();
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::vector <ChunkedDecoder::Trailer> const& Request::getTrailers() const
+    {
+        return connection_->getTrailers();
+    }
 //-------------------------------------------------------------------------------------------------------
     std::ostream& Request::getStream(std::ostream& stream)
     {
@@ -70,7 +139,7 @@ namespace Rest {
 //-------------------------------------------------------------------------------------------------------
     std::string Request::getType()
     {
-        return connection_->getRequestHeader().requestType;
+        return connection_->getRequestHeader().requestType.to_string();
     }
 //#######################################################################################################
 }
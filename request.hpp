@@ -3,9 +3,12 @@
 #include "forward.hpp"
 #include "connection.hpp"
 #include "request_header.hpp"
-#include "url.hpp"
+#include "url_parser.hpp"
+#include "router.hpp"
+#include "snapshot.hpp"
 
 #include <string>
+#include <stdexcept>
 #include <unordered_map>
 
 namespace Rest {
@@ -29,6 +32,38 @@ namespace Rest {
          */
         std::string param(std::string const& id);
 
+        /**
+         *  Like getParameter, but without copying.
+         *  The view is valid until the handler returns.
+         *
+         *  @param id One of the specified ids for the API call.
+         *
+         *  @return The value behind the id, still percent-encoded, or an empty view.
+         */
+        boost::string_view getParameterView(std::string const& id) const;
+
+        /**
+         *  Gets an URL parameter converted to T, which is one of std::string, boost::string_view,
+         *  std::int32_t, std::int64_t, std::uint32_t, std::uint64_t or Uuid.
+         *  Parameters declared with the matching type, like ":id<u64>" for std::uint64_t,
+         *  were converted while routing already and are returned directly.
+         *
+         *  @param id One of the specified ids for the API call.
+         *
+         *  @throw std::out_of_range if there is no such parameter.
+         *  @throw std::invalid_argument if the parameter is not convertible to T.
+         *
+         *  @return The converted value.
+         */
+        template <typename T>
+        T getParameter(std::string const& id) const
+        {
+            auto index = findParameter(id);
+            if (index == match_.parameterCount)
+                throw std::out_of_range("No such parameter: " + id);
+            return extractParameter <T> (match_.parameters[index], match_.values[index]);
+        }
+
         /**
          *  Returns the request type. Which is get, put, post, ...
          */
@@ -67,6 +102,28 @@ namespace Rest {
          */
         std::string getString();
 
+        /**
+         *  Passes the body piece by piece to a callback, without buffering it as a whole.
+         *  The next piece is only read from the socket once the callback returns.
+         *
+         *  @param onData Called for every piece. The view is only valid during the call.
+         *
+         *  @return The body size.
+         */
+        std::size_t readBody(std::function <void(boost::string_view)> const& onData);
+
+        /**
+         *  Returns the next piece of the body, for reading it at your own pace.
+         *
+         *  @return A view valid until the next call, empty at the end of the body.
+         */
+        boost::string_view readBodyChunk();
+
+        /**
+         *  Returns the trailer fields sent after a chunked body, once the body has been read.
+         */
+        std::vector <ChunkedDecoder::Trailer> const& getTrailers() const;
+
         /**
          *  Writes the body into a stream.
          *
@@ -116,30 +173,66 @@ namespace Rest {
          *  Returns the query parameters.
          *  "/users?sort=desc" => "sort = desc"
          *
-         *  Only supports key=value pairs, the key must be unique
+         *  Keys and values are percent-decoded. Of repeated keys only the first value is contained,
+         *  see getQueryParameters for all of them. The query is decoded on the first call of either.
          *
          *  @return An assoicative container for the key value pairs.
          */
         std::unordered_map <std::string, std::string> getQuery() const;
 
+        /**
+         *  Returns all query parameters in the order they were sent, including repeated keys.
+         *  "/users?tag=a&tag=b" => {"tag", "a"}, {"tag", "b"}
+         *
+         *  @return The decoded key value pairs.
+         */
+        std::vector <std::pair <std::string, std::string>> const& getQueryParameters() const;
+
         /**
          *  Gets a field from the request header.
          *
-         *  @param key The header entry key.
+         *  @param key The header entry key, case insensitive.
          *
          *  @return The corresponding value to the key. Will return an empty string if it was not specified.
          */
-        std::string getHeaderField(std::string const& key);
+        std::string getHeaderField(std::string const& key) const;
+
+        /**
+         *  Like getHeaderField, but without copying.
+         *  The view is valid until the handler returns.
+         *
+         *  @param key The header entry key, case insensitive.
+         *
+         *  @return The value or an empty view if it was not specified.
+         */
+        boost::string_view getHeaderView(boost::string_view key) const;
+        boost::string_view getHeaderView(KnownHeader header) const;
+
+        /**
+         *  Returns the whole request header. Valid until the handler returns.
+         */
+        RequestHeader const& getRequestHeader() const;
 
     private:
         // cannot be created by user.
         Request(std::shared_ptr <RestConnection>& connection,
-                std::unordered_map <std::string, std::string> parameters,
-                Url url);
+                boost::intrusive_ptr <SnapshotBase const> routes,
+                std::vector <std::string> const& parameterNames,
+                Router::Match const& match,
+                UrlView target);
+
+        /**
+         *  @return The index of the parameter, or match_.parameterCount if there is none.
+         */
+        std::size_t findParameter(std::string const& id) const;
 
     private:
         std::shared_ptr <RestConnection> connection_;
-        std::unordered_map <std::string, std::string> parameters_;
-        Url url_;
+        boost::intrusive_ptr <SnapshotBase const> routes_; // keeps the routes alive that parameterNames_ belongs to.
+        std::vector <std::string> const* parameterNames_; // owned by the route.
+        Router::Match match_; // parameter values point into the request header.
+        UrlView target_; // points into the request header, like match_.
+        mutable std::vector <std::pair <std::string, std::string>> queryParameters_; // decoded on first use.
+        mutable bool queryDecoded_;
     };
 } // namespace Rest
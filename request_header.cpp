@@ -0,0 +1,179 @@
+#include "request_header.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        // same order as KnownHeader.
+        boost::string_view const knownHeaderNames[knownHeaderCount] = {
+            "Accept",
+            "Accept-Charset",
+            "Accept-Encoding",
+            "Accept-Language",
+            "Authorization",
+            "Cache-Control",
+            "Connection",
+            "Content-Encoding",
+            "Content-Length",
+            "Content-Type",
+            "Cookie",
+            "Date",
+            "Expect",
+            "Host",
+            "If-Match",
+            "If-Modified-Since",
+            "If-None-Match",
+            "If-Range",
+            "If-Unmodified-Since",
+            "Origin",
+            "Range",
+            "Referer",
+            "Transfer-Encoding",
+            "Upgrade",
+            "User-Agent",
+            "X-Forwarded-For"
+        };
+
+        /**
+         *  A perfect hash over the known names: length, first, middle and last character, folded to lower case.
+         *  When adding names, make sure they still land in distinct slots.
+         */
+        std::size_t hashHeaderName(boost::string_view name)
+        {
+            auto fold = [](char c) { return static_cast <std::size_t> (static_cast <unsigned char> (c) | 0x20); };
+            return (name.size() + 11 * fold(name.front()) + 6 * fold(name.back()) + fold(name[name.size() / 2])) & 63;
+        }
+
+        struct KnownHeaderTable
+        {
+            std::array <KnownHeader, 64> slots;
+
+            KnownHeaderTable()
+            {
+                slots.fill(KnownHeader::Unknown);
+                for (std::size_t i = 0; i != knownHeaderCount; ++i)
+                    slots[hashHeaderName(knownHeaderNames[i])] = static_cast <KnownHeader> (i);
+            }
+        };
+    }
+//#######################################################################################################
+    KnownHeader identifyHeader(boost::string_view name)
+    {
+        static KnownHeaderTable const table;
+
+        if (name.empty())
+            return KnownHeader::Unknown;
+
+        auto candidate = table.slots[hashHeaderName(name)];
+        if (candidate != KnownHeader::Unknown && boost::algorithm::iequals(name, getHeaderName(candidate)))
+            return candidate;
+        return KnownHeader::Unknown;
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view getHeaderName(KnownHeader header)
+    {
+        if (header == KnownHeader::Unknown)
+            return {};
+        return knownHeaderNames[static_cast <std::size_t> (header)];
+    }
+//#######################################################################################################
+    HeaderFields::HeaderFields()
+        : entries_()
+        , known_()
+    {
+        entries_.reserve(32);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void HeaderFields::add(boost::string_view name, boost::string_view value)
+    {
+        auto known = identifyHeader(name);
+        entries_.push_back({name, value, known});
+        if (known != KnownHeader::Unknown && known_[static_cast <std::size_t> (known)] == 0)
+            known_[static_cast <std::size_t> (known)] = static_cast <std::uint16_t> (entries_.size());
+    }
+//-------------------------------------------------------------------------------------------------------
+    void HeaderFields::clear()
+    {
+        entries_.clear(); // keeps the capacity
+        known_.fill(0);
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view HeaderFields::get(KnownHeader header) const
+    {
+        if (header == KnownHeader::Unknown)
+            return {};
+        auto index = known_[static_cast <std::size_t> (header)];
+        if (index == 0)
+            return {};
+        return entries_[index - 1].value;
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view HeaderFields::get(boost::string_view name) const
+    {
+        auto entry = find(name);
+        if (entry == end())
+            return {};
+        return entry->value;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool HeaderFields::contains(KnownHeader header) const
+    {
+        return header != KnownHeader::Unknown && known_[static_cast <std::size_t> (header)] != 0;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool HeaderFields::contains(boost::string_view name) const
+    {
+        return find(name) != end();
+    }
+//-------------------------------------------------------------------------------------------------------
+    HeaderFields::const_iterator HeaderFields::find(boost::string_view name) const
+    {
+        auto known = identifyHeader(name);
+        if (known != KnownHeader::Unknown)
+        {
+            auto index = known_[static_cast <std::size_t> (known)];
+            if (index == 0)
+                return end();
+            return begin() + (index - 1);
+        }
+
+        for (auto entry = begin(); entry != end(); ++entry)
+        {
+            if (entry->known == KnownHeader::Unknown && boost::algorithm::iequals(entry->name, name))
+                return entry;
+        }
+        return end();
+    }
+//-------------------------------------------------------------------------------------------------------
+    HeaderFields::const_iterator HeaderFields::begin() const
+    {
+        return entries_.begin();
+    }
+//-------------------------------------------------------------------------------------------------------
+    HeaderFields::const_iterator HeaderFields::end() const
+    {
+        return entries_.end();
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t HeaderFields::size() const
+    {
+        return entries_.size();
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool HeaderFields::empty() const
+    {
+        return entries_.empty();
+    }
+//#######################################################################################################
+    void RequestHeader::clear()
+    {
+        requestType = {};
+        httpVersion = {};
+        url = {};
+        entries.clear();
+    }
+//#######################################################################################################
+} // namespace Rest
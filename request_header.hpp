@@ -1,21 +1,135 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <boost/utility/string_view.hpp>
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
 
 namespace Rest {
 
+    /**
+     *  Header fields that are identified while parsing, so that looking them up does not compare strings.
+     */
+    enum class KnownHeader : std::uint8_t
+    {
+        Accept,
+        AcceptCharset,
+        AcceptEncoding,
+        AcceptLanguage,
+        Authorization,
+        CacheControl,
+        Connection,
+        ContentEncoding,
+        ContentLength,
+        ContentType,
+        Cookie,
+        Date,
+        Expect,
+        Host,
+        IfMatch,
+        IfModifiedSince,
+        IfNoneMatch,
+        IfRange,
+        IfUnmodifiedSince,
+        Origin,
+        Range,
+        Referer,
+        TransferEncoding,
+        Upgrade,
+        UserAgent,
+        XForwardedFor,
+        Unknown // must stay last.
+    };
+
+    constexpr std::size_t knownHeaderCount = static_cast <std::size_t> (KnownHeader::Unknown);
+
+    /**
+     *  Identifies a header field name, case insensitive.
+     *
+     *  @return The matching KnownHeader or KnownHeader::Unknown.
+     */
+    KnownHeader identifyHeader(boost::string_view name);
+
+    /**
+     *  Returns the usual spelling of a known header field name, like "Content-Length".
+     */
+    boost::string_view getHeaderName(KnownHeader header);
+
+    /**
+     *  The header fields of a request in the order they were received.
+     *  Does not own the names and values, they point into the head buffer of the connection.
+     *  All lookups are case insensitive and return the first field of that name.
+     */
+    class HeaderFields
+    {
+    public:
+        struct Entry
+        {
+            boost::string_view name;
+            boost::string_view value;
+            KnownHeader known;
+        };
+
+        using const_iterator = std::vector <Entry>::const_iterator;
+
+        HeaderFields();
+
+        /**
+         *  Appends a field. The strings must outlive this object or the next call to clear.
+         */
+        void add(boost::string_view name, boost::string_view value);
+
+        /**
+         *  Removes all fields, keeps the memory.
+         */
+        void clear();
+
+        /**
+         *  Returns the value of a field, or an empty view if it was not sent.
+         */
+        boost::string_view get(KnownHeader header) const;
+        boost::string_view get(boost::string_view name) const;
+
+        /**
+         *  Returns whether the field was sent.
+         */
+        bool contains(KnownHeader header) const;
+        bool contains(boost::string_view name) const;
+
+        /**
+         *  Returns the field or end().
+         */
+        const_iterator find(boost::string_view name) const;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+        std::size_t size() const;
+        bool empty() const;
+
+    private:
+        std::vector <Entry> entries_;
+        std::array <std::uint16_t, knownHeaderCount> known_; // index + 1 of the first known field, 0 if absent.
+    };
+
     /**
      *  A holder for http requests.
-     *  Containing the first line of the header.
+     *  Containing the first line of the header and the header fields.
+     *  Everything points into the head buffer of the connection and is valid until its next request.
      */
     struct RequestHeader
     {
-        std::string requestType;
-        std::string httpVersion;
-        std::string url;
+        boost::string_view requestType;
+        boost::string_view httpVersion;
+        boost::string_view url;
+
+        HeaderFields entries;
 
-        std::unordered_map <std::string, std::string> entries;
+        /**
+         *  Prepares for the next request, keeps the memory.
+         */
+        void clear();
     };
 
 } // namespace Rest
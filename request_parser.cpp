@@ -0,0 +1,257 @@
+#include "request_parser.hpp"
+#include "char_scan.hpp"
+
+#include <algorithm>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        bool isDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+    }
+//#######################################################################################################
+    RequestParser::RequestParser(std::size_t maxHeadSize, std::size_t maxFields)
+        : maxHeadSize_(maxHeadSize)
+        , maxFields_(maxFields)
+        , state_(State::RequestLineStart)
+        , position_(0)
+        , method_()
+        , target_()
+        , version_()
+        , field_()
+        , fields_()
+        , error_("")
+    {
+        fields_.reserve(32);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RequestParser::reset()
+    {
+        state_ = State::RequestLineStart;
+        position_ = 0;
+        method_ = {};
+        target_ = {};
+        version_ = {};
+        field_ = {};
+        fields_.clear(); // keeps the capacity
+        error_ = "";
+    }
+//-------------------------------------------------------------------------------------------------------
+    RequestParser::Result RequestParser::fail(char const* error)
+    {
+        state_ = State::Failed;
+        error_ = error;
+        return Result::Error;
+    }
+//-------------------------------------------------------------------------------------------------------
+    RequestParser::Result RequestParser::parse(char const* data, std::size_t size)
+    {
+        if (state_ == State::Complete)
+            return Result::Complete;
+        if (state_ == State::Failed)
+            return Result::Error;
+
+        auto limit = std::min(size, maxHeadSize_);
+        while (position_ < limit)
+        {
+            auto c = static_cast <unsigned char> (data[position_]);
+            switch (state_)
+            {
+                case (State::RequestLineStart):
+                {
+                    // empty lines in front of a request shall be ignored (RFC 7230 3.5).
+                    if (c == '\r' || c == '\n')
+                    {
+                        ++position_;
+                        break;
+                    }
+                    method_.offset = position_;
+                    state_ = State::Method;
+                    break;
+                }
+                case (State::Method):
+                {
+                    position_ = scanToken(data + position_, data + limit) - data;
+                    if (position_ == limit)
+                        break;
+                    if (data[position_] != ' ')
+                        return fail("Invalid character in request method.");
+                    method_.length = position_ - method_.offset;
+                    if (method_.length == 0)
+                        return fail("Request method is empty.");
+                    state_ = State::TargetStart;
+                    ++position_;
+                    break;
+                }
+                case (State::TargetStart):
+                {
+                    target_.offset = position_;
+                    state_ = State::Target;
+                    break;
+                }
+                case (State::Target):
+                {
+                    position_ = scanTarget(data + position_, data + limit) - data;
+                    if (position_ == limit)
+                        break;
+                    if (data[position_] != ' ')
+                        return fail("Invalid character in request target.");
+                    target_.length = position_ - target_.offset;
+                    if (target_.length == 0)
+                        return fail("Request target is empty.");
+                    state_ = State::VersionStart;
+                    ++position_;
+                    break;
+                }
+                case (State::VersionStart):
+                {
+                    version_.offset = position_;
+                    state_ = State::Version;
+                    break;
+                }
+                case (State::Version):
+                {
+                    if (c == '\r' || c == '\n')
+                    {
+                        version_.length = position_ - version_.offset;
+                        auto version = version_.view(data);
+                        if (version.size() != 8 || version.substr(0, 5) != "HTTP/" ||
+                            !isDigit(version[5]) || version[6] != '.' || !isDigit(version[7]))
+                            return fail("Request does not contain a valid HTTP version.");
+                        state_ = c == '\r' ? State::RequestLineEnd : State::FieldStart;
+                    }
+                    else if (c < 0x21 || c == 0x7F)
+                        return fail("Invalid character in HTTP version.");
+                    ++position_;
+                    break;
+                }
+                case (State::RequestLineEnd):
+                case (State::FieldLineEnd):
+                {
+                    if (c != '\n')
+                        return fail("Carriage return without line feed.");
+                    state_ = State::FieldStart;
+                    ++position_;
+                    break;
+                }
+                case (State::FieldStart):
+                {
+                    if (c == '\r')
+                    {
+                        state_ = State::HeadEnd;
+                        ++position_;
+                        break;
+                    }
+                    if (c == '\n')
+                    {
+                        state_ = State::Complete;
+                        ++position_;
+                        return Result::Complete;
+                    }
+                    if (c == ' ' || c == '\t')
+                        return fail("Obsolete header line folding is not supported.");
+                    if (fields_.size() >= maxFields_)
+                        return fail("Too many header fields.");
+                    field_.name.offset = position_;
+                    state_ = State::FieldName;
+                    break;
+                }
+                case (State::FieldName):
+                {
+                    position_ = scanToken(data + position_, data + limit) - data;
+                    if (position_ == limit)
+                        break;
+                    if (data[position_] != ':')
+                        return fail("Invalid character in header field name.");
+                    field_.name.length = position_ - field_.name.offset;
+                    if (field_.name.length == 0)
+                        return fail("HTTP header entry has no name.");
+                    state_ = State::FieldValueStart;
+                    ++position_;
+                    break;
+                }
+                case (State::FieldValueStart):
+                {
+                    if (c == ' ' || c == '\t')
+                    {
+                        ++position_;
+                        break;
+                    }
+                    field_.value.offset = position_;
+                    state_ = State::FieldValue;
+                    break;
+                }
+                case (State::FieldValue):
+                {
+                    position_ = scanFieldValue(data + position_, data + limit) - data;
+                    if (position_ == limit)
+                        break;
+                    auto stop = data[position_];
+                    if (stop != '\r' && stop != '\n')
+                        return fail("Invalid character in header field value.");
+
+                    // strip trailing whitespace, the value starts with something else.
+                    auto valueEnd = position_;
+                    while (valueEnd > field_.value.offset && (data[valueEnd - 1] == ' ' || data[valueEnd - 1] == '\t'))
+                        --valueEnd;
+                    field_.value.length = valueEnd - field_.value.offset;
+                    fields_.push_back(field_);
+                    state_ = stop == '\r' ? State::FieldLineEnd : State::FieldStart;
+                    ++position_;
+                    break;
+                }
+                case (State::HeadEnd):
+                {
+                    if (c != '\n')
+                        return fail("Carriage return without line feed.");
+                    state_ = State::Complete;
+                    ++position_;
+                    return Result::Complete;
+                }
+                case (State::Complete):
+                    return Result::Complete;
+                case (State::Failed):
+                    return Result::Error;
+            }
+        }
+
+        if (position_ >= maxHeadSize_)
+            return fail("Request header is too large.");
+        return Result::Incomplete;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t RequestParser::getHeadSize() const
+    {
+        return position_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    BufferRange RequestParser::getMethod() const
+    {
+        return method_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    BufferRange RequestParser::getTarget() const
+    {
+        return target_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    BufferRange RequestParser::getVersion() const
+    {
+        return version_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::vector <RequestParser::Field> const& RequestParser::getFields() const
+    {
+        return fields_;
+    }
+//-------------------------------------------------------------------------------------------------------
+    char const* RequestParser::getError() const
+    {
+        return error_;
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  A part of the receive buffer, stored as offset and length,
+     *  so that it survives the buffer being moved or grown.
+     */
+    struct BufferRange
+    {
+        std::size_t offset = 0;
+        std::size_t length = 0;
+
+        /**
+         *  Returns the range as a view into the buffer it was taken from.
+         */
+        boost::string_view view(char const* buffer) const
+        {
+            return {buffer + offset, length};
+        }
+    };
+
+    /**
+     *  An incremental HTTP/1.x request head parser.
+     *  It works directly on the receive buffer without copying anything and can be fed partial data:
+     *  Call parse again with the same, but longer, buffer and it continues where it stopped.
+     *  Header field values are stripped of surrounding whitespace.
+     *  Runs of method, target and field characters are skipped with the vectorized scanners in char_scan.hpp.
+     */
+    class RequestParser
+    {
+    public:
+        enum class Result
+        {
+            Complete,
+            Incomplete,
+            Error
+        };
+
+        struct Field
+        {
+            BufferRange name;
+            BufferRange value;
+        };
+
+        /**
+         *  @param maxHeadSize A head that is not complete within this many bytes is an error.
+         *  @param maxFields Maximum amount of header fields.
+         */
+        RequestParser(std::size_t maxHeadSize = 65536, std::size_t maxFields = 100);
+
+        /**
+         *  Continues parsing.
+         *
+         *  @param data The start of the request. Must contain everything passed on previous calls.
+         *  @param size Amount of bytes received so far.
+         *
+         *  @return Complete once the empty line terminating the head has been seen.
+         */
+        Result parse(char const* data, std::size_t size);
+
+        /**
+         *  Prepares the parser for the next request.
+         */
+        void reset();
+
+        /**
+         *  Returns the size of the complete head including the empty line.
+         *  The body starts right after.
+         */
+        std::size_t getHeadSize() const;
+
+        BufferRange getMethod() const;
+        BufferRange getTarget() const;
+        BufferRange getVersion() const;
+        std::vector <Field> const& getFields() const;
+
+        /**
+         *  Returns a description of what went wrong, if parse returned Error.
+         */
+        char const* getError() const;
+
+    private:
+        enum class State
+        {
+            RequestLineStart,
+            Method,
+            TargetStart,
+            Target,
+            VersionStart,
+            Version,
+            RequestLineEnd,
+            FieldStart,
+            FieldName,
+            FieldValueStart,
+            FieldValue,
+            FieldLineEnd,
+            HeadEnd,
+            Complete,
+            Failed
+        };
+
+        Result fail(char const* error);
+
+    private:
+        std::size_t maxHeadSize_;
+        std::size_t maxFields_;
+
+        State state_;
+        std::size_t position_; // everything before has been parsed.
+
+        BufferRange method_;
+        BufferRange target_;
+        BufferRange version_;
+        Field field_; // the field currently parsed.
+        std::vector <Field> fields_;
+
+        char const* error_;
+    };
+
+} // namespace Rest
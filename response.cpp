@@ -26,6 +26,11 @@ namespace Rest
     void Response::send(std::string const& message)
     {
         connection_->sendString(message, header_);
+    }
+//-------------------------------------------------------------------------------------------------------
+    ChunkedWriter& Response::stream(std::size_t coalesceSize)
+    {
+        return connection_->sendChunked(header_, coalesceSize);
     }
 //-------------------------------------------------------------------------------------------------------
     RestConnection& Response::getConnection()
@@ -58,6 +63,12 @@ namespace Rest
 //-------------------------------------------------------------------------------------------------------
     void Response::sendStatus(int code)
     {
+        // nothing custom in the header, a prepared response does.
+        if (header_.responseHeaderPairs.empty() && header_.httpVersion == "HTTP/1.1" && connection_->sendCannedStatus(code))
+        {
+            status(code);
+            return;
+        }
         status(code).send(header_.responseString);
     }
 //-------------------------------------------------------------------------------------------------------
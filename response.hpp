@@ -76,6 +76,21 @@ namespace Rest {
          */
         void sendFile(std::string const& fileName, bool autoDetectContentType = true);
 
+        /**
+         *  Starts a response whose body is written piece by piece, as it is produced.
+         *  The body is sent with chunked transfer encoding, so no Content-Length is needed.
+         *
+         *  auto& out = response.stream();
+         *  while (cursor.next())
+         *      out << cursor.row() << "\n";
+         *
+         *  @param coalesceSize Pieces are collected until this many bytes are pending, then sent as one chunk.
+         *                      Flush the stream to send earlier.
+         *
+         *  @return A stream, valid until the handler returns. The body ends with the handler or ChunkedWriter::end.
+         */
+        ChunkedWriter& stream(std::size_t coalesceSize = 8192);
+
         /**
          *  Sends a status code with the string representation as body.
          *  Equivalent to status(code).send(...)
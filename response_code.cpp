@@ -0,0 +1,199 @@
+#include "response_code.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        struct StatusEntry
+        {
+            template <std::size_t N>
+            constexpr StatusEntry(int code, char const (&line)[N])
+                : code(code)
+                , line(line)
+                , size(N - 1)
+            {
+            }
+
+            int code;
+            char const* line;
+            std::size_t size;
+        };
+
+        constexpr std::size_t prefixSize = 13; // "HTTP/1.1 NNN "
+
+        constexpr StatusEntry statusTable[] = {
+            {100, "HTTP/1.1 100 Continue\r\n"},
+            {101, "HTTP/1.1 101 Switching Protocols\r\n"},
+            {102, "HTTP/1.1 102 Processing\r\n"},
+
+            {200, "HTTP/1.1 200 OK\r\n"},
+            {201, "HTTP/1.1 201 Created\r\n"},
+            {202, "HTTP/1.1 202 Accepted\r\n"},
+            {203, "HTTP/1.1 203 Non-Authoritative Information\r\n"},
+            {204, "HTTP/1.1 204 No Content\r\n"},
+            {205, "HTTP/1.1 205 Reset Content\r\n"},
+            {206, "HTTP/1.1 206 Partial Content\r\n"},
+            {207, "HTTP/1.1 207 Multi-Status\r\n"},
+            {208, "HTTP/1.1 208 Already Reported\r\n"},
+            {226, "HTTP/1.1 226 Im Used\r\n"},
+
+            {300, "HTTP/1.1 300 Multiple Choices\r\n"},
+            {301, "HTTP/1.1 301 Moved Permanently\r\n"},
+            {302, "HTTP/1.1 302 Found\r\n"},
+            {303, "HTTP/1.1 303 See Other\r\n"},
+            {304, "HTTP/1.1 304 Not Modified\r\n"},
+            {305, "HTTP/1.1 305 Use Proxy\r\n"},
+            {306, "HTTP/1.1 306 Switch Proxy\r\n"},
+            {307, "HTTP/1.1 307 Temporary Redirect\r\n"},
+            {308, "HTTP/1.1 308 Permanent Redirect\r\n"},
+
+            {400, "HTTP/1.1 400 Bad Request\r\n"},
+            {401, "HTTP/1.1 401 Unauthorized\r\n"},
+            {402, "HTTP/1.1 402 Payment Required\r\n"},
+            {403, "HTTP/1.1 403 Forbidden\r\n"},
+            {404, "HTTP/1.1 404 Not Found\r\n"},
+            {405, "HTTP/1.1 405 Method Not Allowed\r\n"},
+            {406, "HTTP/1.1 406 Not Acceptable\r\n"},
+            {407, "HTTP/1.1 407 Proxy Authentication Required\r\n"},
+            {408, "HTTP/1.1 408 Request Timeout\r\n"},
+            {409, "HTTP/1.1 409 Conflict\r\n"},
+            {410, "HTTP/1.1 410 Gone\r\n"},
+            {411, "HTTP/1.1 411 Length Required\r\n"},
+            {412, "HTTP/1.1 412 Precondition Failed\r\n"},
+            {413, "HTTP/1.1 413 Payload Too Large\r\n"},
+            {414, "HTTP/1.1 414 Request-URI Too Long\r\n"},
+            {415, "HTTP/1.1 415 Unsupported Media Type\r\n"},
+            {416, "HTTP/1.1 416 Requested Range Not Satisfiable\r\n"},
+            {417, "HTTP/1.1 417 Expectation Failed\r\n"},
+            {418, "HTTP/1.1 418 I'm a teapot\r\n"},
+            {419, "HTTP/1.1 419 Authentication Timeout\r\n"},
+            {421, "HTTP/1.1 421 Misdirect Request\r\n"},
+            {422, "HTTP/1.1 422 Unprocessable Entity\r\n"},
+            {423, "HTTP/1.1 423 Locked\r\n"},
+            {424, "HTTP/1.1 424 Failed Dependency\r\n"},
+            {426, "HTTP/1.1 426 Upgrade Required\r\n"},
+            {428, "HTTP/1.1 428 Precondition Required\r\n"},
+            {429, "HTTP/1.1 429 Too Many Requests\r\n"},
+            {431, "HTTP/1.1 431 Request Header Field Too Large\r\n"},
+            {440, "HTTP/1.1 440 Login Timeout\r\n"},
+            {444, "HTTP/1.1 444 No Response\r\n"},
+            {449, "HTTP/1.1 449 Retry With\r\n"},
+            {450, "HTTP/1.1 450 Blocked by Window Parental Controls\r\n"},
+            {451, "HTTP/1.1 451 Unavailable For Legal Reasons\r\n"},
+            {494, "HTTP/1.1 494 Request Header Too Large\r\n"},
+            {495, "HTTP/1.1 495 Cert Error\r\n"},
+            {496, "HTTP/1.1 496 No Cert\r\n"},
+            {497, "HTTP/1.1 497 HTTP to HTTPS\r\n"},
+            {498, "HTTP/1.1 498 Token expired/invalid\r\n"},
+            {499, "HTTP/1.1 499 Client Closed Request\r\n"},
+
+            {500, "HTTP/1.1 500 Internal Server Error\r\n"},
+            {501, "HTTP/1.1 501 Not Implemented\r\n"},
+            {502, "HTTP/1.1 502 Bad Gateway\r\n"},
+            {503, "HTTP/1.1 503 Service Unavailable\r\n"},
+            {504, "HTTP/1.1 504 Gateway Timeout\r\n"},
+            {505, "HTTP/1.1 505 HTTP Version Not Supported\r\n"},
+            {507, "HTTP/1.1 507 Insufficient Storage\r\n"},
+            {508, "HTTP/1.1 508 Loop Detected\r\n"},
+            {509, "HTTP/1.1 509 Bandwidth Limit Exceeded\r\n"},
+            {510, "HTTP/1.1 510 Not Extended\r\n"},
+            {511, "HTTP/1.1 511 Network Authentication Required\r\n"},
+            {520, "HTTP/1.1 520 Unknown Error\r\n"},
+        };
+
+        constexpr int firstCode = 100;
+        constexpr int lastCode = 599;
+
+        /**
+         *  Maps a status code to its position in statusTable plus one, 0 for unknown codes.
+         */
+        struct StatusIndex
+        {
+            std::uint8_t slots[lastCode - firstCode + 1];
+        };
+
+        constexpr StatusIndex makeStatusIndex()
+        {
+            StatusIndex index {};
+            for (std::size_t i = 0; i != sizeof(statusTable) / sizeof(statusTable[0]); ++i)
+                index.slots[statusTable[i].code - firstCode] = static_cast <std::uint8_t> (i + 1);
+            return index;
+        }
+
+        constexpr StatusIndex statusIndex = makeStatusIndex();
+
+        StatusEntry const* findStatus(int statusCode)
+        {
+            if (statusCode < firstCode || statusCode > lastCode)
+                return nullptr;
+            auto slot = statusIndex.slots[statusCode - firstCode];
+            return slot == 0 ? nullptr : &statusTable[slot - 1];
+        }
+
+        /**
+         *  The prepared responses of one status code.
+         */
+        struct CannedResponses
+        {
+            int code;
+            std::array <std::string, 2> heads; // index: keepAlive
+        };
+
+        CannedResponses makeCanned(int code)
+        {
+            CannedResponses canned {code, {}};
+            for (int keepAlive = 0; keepAlive != 2; ++keepAlive)
+            {
+                auto& head = canned.heads[keepAlive];
+                head = getStatusLine(code).to_string();
+                head += "Content-Length: " + std::to_string(getReasonPhrase(code).size()) + "\r\n";
+                head += "Content-Type: text/plain; charset=UTF-8\r\n";
+                head += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+            }
+            return canned;
+        }
+    }
+//#######################################################################################################
+    boost::string_view getStatusLine(int statusCode)
+    {
+        auto entry = findStatus(statusCode);
+        if (entry == nullptr)
+            return {};
+        return {entry->line, entry->size};
+    }
+//-------------------------------------------------------------------------------------------------------
+    boost::string_view getReasonPhrase(int statusCode)
+    {
+        auto entry = findStatus(statusCode);
+        if (entry == nullptr)
+            return {};
+        return {entry->line + prefixSize, entry->size - prefixSize - 2};
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::string translateResponseCode(int statusCode)
+    {
+        return getReasonPhrase(statusCode).to_string();
+    }
+//-------------------------------------------------------------------------------------------------------
+    CannedResponse getCannedResponse(int statusCode, bool keepAlive, bool withBody)
+    {
+        // the replies to broken requests, unknown routes and timeouts.
+        static std::array <CannedResponses, 10> const canned {{
+            makeCanned(400), makeCanned(404), makeCanned(405), makeCanned(408), makeCanned(413),
+            makeCanned(414), makeCanned(431), makeCanned(500), makeCanned(501), makeCanned(503)
+        }};
+
+        for (auto const& responses : canned)
+        {
+            if (responses.code == statusCode)
+                return {responses.heads[keepAlive ? 1 : 0], withBody ? getReasonPhrase(statusCode) : boost::string_view{}};
+        }
+        return {};
+    }
+//#######################################################################################################
+}
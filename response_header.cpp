@@ -1,23 +1,123 @@
 #include "response_header.hpp"
+#include "response_code.hpp"
 
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <algorithm>
 #include <sstream>
 
 namespace Rest
 {
 //#######################################################################################################
-    std::string ResponseHeader::toString() const
+    namespace
     {
-        std::stringstream builder;
-        builder << httpVersion << " " << responseCode << " " << responseString << "\r\n";
-        for (auto const& i : responseHeaderPairs) {
-            builder << i.first << ": " << i.second << "\r\n";
+        /**
+         *  Writes the decimal digits of a number so that they end at end, like std::to_chars does at the front.
+         *
+         *  @return The first digit.
+         */
+        char* formatDecimal(std::uint64_t number, char* end)
+        {
+            do {
+                *--end = static_cast <char> ('0' + number % 10);
+                number /= 10;
+            } while (number != 0);
+            return end;
         }
-        builder << "\r\n";
 
+        void put(std::streambuf& out, boost::string_view text)
+        {
+            out.sputn(text.data(), static_cast <std::streamsize> (text.size()));
+        }
+    }
+//#######################################################################################################
+    std::string& ResponseFields::operator[](boost::string_view name)
+    {
+        auto field = find(name);
+        if (field != end())
+            return field->second;
+
+        // most responses have a handful of fields, that way they are added without growing.
+        if (fields_.empty())
+            fields_.reserve(8);
+        fields_.emplace_back(name.to_string(), std::string{});
+        return fields_.back().second;
+    }
+//-------------------------------------------------------------------------------------------------------
+    ResponseFields::iterator ResponseFields::find(boost::string_view name)
+    {
+        return std::find_if(fields_.begin(), fields_.end(), [name](value_type const& field) {
+            return boost::algorithm::iequals(field.first, name);
+        });
+    }
+//-------------------------------------------------------------------------------------------------------
+    ResponseFields::const_iterator ResponseFields::find(boost::string_view name) const
+    {
+        return std::find_if(fields_.begin(), fields_.end(), [name](value_type const& field) {
+            return boost::algorithm::iequals(field.first, name);
+        });
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t ResponseFields::erase(boost::string_view name)
+    {
+        auto field = find(name);
+        if (field == end())
+            return 0;
+        fields_.erase(field);
+        return 1;
+    }
+//#######################################################################################################
+    std::string ResponseHeader::toString() const
+    {
+        std::stringbuf builder;
+        writeTo(builder);
         return builder.str();
     }
 //-------------------------------------------------------------------------------------------------------
-    bool ResponseHeader::isSet(std::string const& key)
+    void ResponseHeader::writeTo(std::streambuf& out) const
+    {
+        writeTo(out, {});
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ResponseHeader::writeTo(std::streambuf& out, boost::string_view extraFields) const
+    {
+        // the usual status lines come complete from the table.
+        auto statusLine = getStatusLine(responseCode);
+        if (httpVersion == "HTTP/1.1" && !statusLine.empty() && getReasonPhrase(responseCode) == responseString)
+            put(out, statusLine);
+        else
+        {
+            char code[20];
+            auto codeEnd = code + sizeof(code);
+            auto codeBegin = formatDecimal(responseCode, codeEnd);
+
+            put(out, httpVersion);
+            out.sputc(' ');
+            out.sputn(codeBegin, codeEnd - codeBegin);
+            out.sputc(' ');
+            put(out, responseString);
+            put(out, "\r\n");
+        }
+        for (auto const& field : responseHeaderPairs)
+        {
+            put(out, field.first);
+            put(out, ": ");
+            put(out, field.second);
+            put(out, "\r\n");
+        }
+        put(out, extraFields);
+        put(out, "\r\n");
+    }
+//-------------------------------------------------------------------------------------------------------
+    void ResponseHeader::setContentLength(std::uint64_t length)
+    {
+        char digits[20];
+        auto end = digits + sizeof(digits);
+        auto begin = formatDecimal(length, end);
+        responseHeaderPairs["Content-Length"].assign(begin, end);
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool ResponseHeader::isSet(std::string const& key) const
     {
         return responseHeaderPairs.find(key) != std::end(responseHeaderPairs);
     }
@@ -28,5 +128,3 @@ namespace Rest
     }
 //#######################################################################################################
 } // namespace Rest
-
-
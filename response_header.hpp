@@ -1,11 +1,55 @@
 #pragma once
 
+#include <boost/utility/string_view.hpp>
+
 #include <string>
-#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <streambuf>
 #include <cstdint>
 
 namespace Rest {
 
+    /**
+     *  The header fields of a response, in the order they were set.
+     *  A flat list instead of a hash map: Responses have few fields, which are found faster by a scan
+     *  and written out without reordering. Names are compared case insensitively.
+     *  Offers the parts of the std::map interface that are used on headers.
+     */
+    class ResponseFields
+    {
+    public:
+        using value_type = std::pair <std::string, std::string>;
+        using iterator = std::vector <value_type>::iterator;
+        using const_iterator = std::vector <value_type>::const_iterator;
+
+        /**
+         *  Returns the value of a field, which is added if it does not exist.
+         */
+        std::string& operator[](boost::string_view name);
+
+        iterator find(boost::string_view name);
+        const_iterator find(boost::string_view name) const;
+
+        /**
+         *  Removes a field.
+         *
+         *  @return The amount of removed fields, 0 or 1.
+         */
+        std::size_t erase(boost::string_view name);
+
+        iterator begin() { return fields_.begin(); }
+        iterator end() { return fields_.end(); }
+        const_iterator begin() const { return fields_.begin(); }
+        const_iterator end() const { return fields_.end(); }
+        std::size_t size() const { return fields_.size(); }
+        bool empty() const { return fields_.empty(); }
+        void clear() { fields_.clear(); }
+
+    private:
+        std::vector <value_type> fields_;
+    };
+
     /**
      *  A pure holder for response information.
      */
@@ -14,7 +58,7 @@ namespace Rest {
         std::string httpVersion = "HTTP/1.1";
         uint16_t responseCode = 200;
         std::string responseString = "OK";
-        std::unordered_map <std::string, std::string> responseHeaderPairs;
+        ResponseFields responseHeaderPairs;
 
         /**
          *  Turns the response header into a conforming header.
@@ -24,6 +68,23 @@ namespace Rest {
          */
         std::string toString() const;
 
+        /**
+         *  Writes the header as toString would, but directly into a stream buffer without building a string.
+         */
+        void writeTo(std::streambuf& out) const;
+
+        /**
+         *  Like writeTo, with preformatted field lines added at the end.
+         *
+         *  @param extraFields Complete lines, each ending with "\r\n".
+         */
+        void writeTo(std::streambuf& out, boost::string_view extraFields) const;
+
+        /**
+         *  Sets the Content-Length field. Formats the number without going through a stream.
+         */
+        void setContentLength(std::uint64_t length);
+
         /**
          *  Shorthand operator for header key value pairs.
          */
@@ -33,7 +94,7 @@ namespace Rest {
          *  Checks whether a certain key value pair exists.
          *  Mostly used internally.
          */
-        bool isSet(std::string const& key);
+        bool isSet(std::string const& key) const;
     };
 
 } // namespace Rest
@@ -1,16 +1,14 @@
 #include "restful.hpp"
 
-#include <cassert>
-#include <algorithm>
-
 namespace Rest
 {
 //#######################################################################################################
-    InterfaceProvider::InterfaceProvider(uint32_t port)
+    InterfaceProvider::InterfaceProvider(uint32_t port, ServerSettings const& settings)
         : server_(
-            std::bind(connectionHandler, this, std::placeholders::_1),
-            std::bind(errorHandler, this, std::placeholders::_1, std::placeholders::_2),
-            port
+            std::bind(&InterfaceProvider::connectionHandler, this, std::placeholders::_1),
+            std::bind(&InterfaceProvider::errorHandler, this, std::placeholders::_1, std::placeholders::_2),
+            port,
+            settings
         )
     {
 
@@ -51,10 +49,104 @@ namespace Rest
         registerRequest("PATCH", url, callback);
         return *this;
     }
+//-------------------------------------------------------------------------------------------------------
+    InterfaceProvider& InterfaceProvider::serveStatic(std::string const& urlPrefix, std::string const& directory)
+    {
+        auto prefix = urlPrefix;
+        while (!prefix.empty() && prefix.back() == '/')
+            prefix.pop_back();
+        auto root = directory;
+        while (!root.empty() && root.back() == '/')
+            root.pop_back();
+
+        auto handler = [root](Request& request, Response& response)
+        {
+            std::string fileName;
+            if (!resolveStaticPath(root, request.getParameterView("path"), fileName) ||
+                !response.getConnection().sendStaticFile(fileName))
+            {
+                response.sendStatus(404);
+            }
+        };
+
+        route("GET", prefix + "/", handler);
+        route("GET", prefix + "/*path", handler);
+        route("HEAD", prefix + "/", handler);
+        route("HEAD", prefix + "/*path", handler);
+        return *this;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool InterfaceProvider::resolveStaticPath(std::string const& root, boost::string_view encodedPath, std::string& fileName)
+    {
+        std::string path;
+        if (!ReducedUrlParser::decode(encodedPath, path))
+            return false;
+
+        // a directory stands for its index.
+        if (path.empty() || path.back() == '/')
+            path += "index.html";
+
+        fileName = root;
+        std::size_t start = 0;
+        while (start <= path.size())
+        {
+            auto end = path.find('/', start);
+            if (end == std::string::npos)
+                end = path.size();
+
+            boost::string_view segment {path.data() + start, end - start};
+            if (segment.empty() || segment == "." || segment == ".." || segment.find('\0') != boost::string_view::npos)
+                return false;
+#ifdef _WIN32
+            if (segment.find('\\') != boost::string_view::npos || segment.find(':') != boost::string_view::npos)
+                return false;
+#endif
+            fileName.push_back('/');
+            fileName.append(segment.data(), segment.size());
+            start = end + 1;
+        }
+        return true;
+    }
 //-------------------------------------------------------------------------------------------------------
     void InterfaceProvider::start()
     {
+        {
+            std::lock_guard <std::mutex> guard {routeLock_};
+            shardRequests_.clear();
+            auto routes = SnapshotCell <RouteTable>::makeSnapshot(requests_);
+            for (std::size_t shard = 0; shard != server_.getShardCount(); ++shard)
+                shardRequests_.emplace_back(new SnapshotCell <RouteTable> (routes));
+        }
         server_.start();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void InterfaceProvider::publishRoutes()
+    {
+        // one copy shared by all shards, each shard only has its own reader counters.
+        auto routes = SnapshotCell <RouteTable>::makeSnapshot(requests_);
+        for (auto& shard : shardRequests_)
+            shard->publish(routes);
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool InterfaceProvider::unregister(std::string const& type, std::string const& url)
+    {
+        std::lock_guard <std::mutex> guard {routeLock_};
+
+        // routes cannot be taken out of the trie, so it is built anew.
+        RouteTable rebuilt;
+        for (auto& request : requests_.requests)
+        {
+            if (request.type == type && request.url == url)
+                continue;
+            rebuilt.router.add(request.type, request.url, rebuilt.requests.size());
+            rebuilt.requests.push_back(std::move(request));
+        }
+
+        auto removed = rebuilt.requests.size() != requests_.requests.size();
+        requests_ = std::move(rebuilt);
+        if (removed)
+            publishRoutes();
+        return removed;
     }
 //-------------------------------------------------------------------------------------------------------
     void InterfaceProvider::stop()
@@ -64,10 +156,13 @@ namespace Rest
 //-------------------------------------------------------------------------------------------------------
     void InterfaceProvider::connectionHandler(std::shared_ptr <RestConnection> connection)
     {
-        Url url;
+        auto const& header = connection->getRequestHeader();
+
+        // the query is only decoded when the handler asks for it, broken encoding is refused right away.
+        UrlView target;
         try
         {
-            url = ReducedUrlParser::parse(connection->getRequestHeader().url);
+            target = ReducedUrlParser::split(header.url);
         }
         catch (...)
         {
@@ -76,12 +171,20 @@ namespace Rest
             response.sendStatus(400);
             return;
         }
+        if (!ReducedUrlParser::isValidEncoding(target.query) || !ReducedUrlParser::isValidEncoding(target.fragment))
+        {
+            Response response (connection);
+            response.sendStatus(400);
+            return;
+        }
 
-        auto type = connection->getRequestHeader().requestType;
-        auto requestList = requests_.find(type);
+        // the snapshot stays alive as long as the request refers to it.
+        auto routes = shardRequests_[connection->getShard()]->acquire();
+        auto const& requests = routes->get();
+        auto type = header.requestType;
 
         // is there any request matching the request type?
-        if (requestList == std::end(requests_))
+        if (!requests.router.hasMethod(type))
         {
             if (type != "GET" && type != "POST" && type != "PUT" && type != "DELETE" && type != "PATCH")
             {
@@ -104,74 +207,55 @@ namespace Rest
         }
 
         // is there a registered request, that matches the url?
-        auto request = std::find_if(std::begin(requestList->second), std::end(requestList->second), [&, this](BuiltRequest const& request) {
-            return matching(url, request.url);
-        });
-
-        if (request == std::end(requestList->second))
+        // the path is taken from the header, the parameters point into it.
+        Router::Match match;
+        if (!requests.router.find(type, target.path, match))
         {
             Response response (connection);
             response.sendStatus(404);
             return;
         }
 
-        auto params = extractParameters(url, request->url);
-
-        request->callback(
-            Request {connection, params, url},
-            Response {connection}
-        );
+        auto const& route = requests.requests[match.route];
+        Request request {connection, routes, route.parameterNames, match, target};
+        Response response {connection};
+        route.invoke(route.handler.get(), request, response);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void InterfaceProvider::invokeFunction(void const* handler, Request& request, Response& response)
+    {
+        (*static_cast <std::function <void(Request, Response)> const*> (handler))(std::move(request), std::move(response));
     }
 //-------------------------------------------------------------------------------------------------------
     void InterfaceProvider::errorHandler(std::shared_ptr <RestConnection> connection, InvalidRequest const& erroneousRequest)
     {
         Response response (connection);
-        response.sendStatus(400);
+        response.sendStatus(erroneousRequest.getStatusCode());
     }
 //-------------------------------------------------------------------------------------------------------
-    bool InterfaceProvider::matching(Url received, Url registered)
+    void InterfaceProvider::registerRequest(std::string const& type, std::string const& url, std::function <void(Request, Response)> callback)
     {
-        auto registeredParts = registered.parsePath();
-        auto receivedParts = received.parsePath(true);
-
-        if (registeredParts.size() != receivedParts.size())
-            return false;
-
-        for (std::size_t i = 0; i != registeredParts.size(); ++i)
-        {
-            if (registeredParts[i]->getType() == PathType::STRING)
-            {
-                // check if path string parts are equal
-                if (registeredParts[i]->getValue() != receivedParts[i]->getValue())
-                    return false;
-            }
-        }
-        return true;
-    }
+        registerRequest(type, url, std::make_shared <std::function <void(Request, Response)>> (std::move(callback)), &invokeFunction);
+    }
 //-------------------------------------------------------------------------------------------------------
-    std::unordered_map <std::string, std::string> InterfaceProvider::extractParameters(Url received, Url registered)
+    void InterfaceProvider::registerRequest(std::string const& type, std::string const& url,
+                                            std::shared_ptr <void const> handler, void (*invoke)(void const*, Request&, Response&))
     {
-        auto registeredParts = registered.parsePath();
-        auto receivedParts = received.parsePath(true);
-
-        assert (registeredParts.size() == receivedParts.size());
+        std::lock_guard <std::mutex> guard {routeLock_};
 
-        std::unordered_map <std::string, std::string> map;
-        for (std::size_t i = 0; i != registeredParts.size(); ++i)
-        {
-            if (registeredParts[i]->getType() == PathType::PARAMETER)
-                map[static_cast <PathParameter*> (registeredParts[i].get())->getId()] = receivedParts[i]->getValue();
-        }
-        return map;
-    }
-//-------------------------------------------------------------------------------------------------------
-    void InterfaceProvider::registerRequest(std::string const& type, std::string const& url, std::function <void(Request, Response)> callback)
-    {
+        auto route = requests_.requests.size();
         BuiltRequest req {
-            ReducedUrlParser::parse(url),
-            callback
+            type,
+            url,
+            requests_.router.add(type, url, route),
+            std::move(handler),
+            invoke
         };
-        requests_[type].push_back(req);
+        requests_.requests.push_back(std::move(req));
+
+        // the server is running already.
+        if (!shardRequests_.empty())
+            publishRoutes();
     }
 //#######################################################################################################
 }
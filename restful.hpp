@@ -5,10 +5,15 @@
 #include "request.hpp"
 #include "response.hpp"
 #include "url_parser.hpp"
+#include "router.hpp"
+#include "snapshot.hpp"
 
 #include <functional>
 #include <cstdint>
 #include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
 
 namespace Rest {
     /**
@@ -19,7 +24,11 @@ namespace Rest {
     class InterfaceProvider
     {
     public:
-        InterfaceProvider(uint32_t port);
+        /**
+         *  @param port The port to bind on.
+         *  @param settings Server tuning, such as the amount of worker threads. See ServerSettings.
+         */
+        InterfaceProvider(uint32_t port, ServerSettings const& settings = {});
 
         // no copy
         InterfaceProvider& operator=(InterfaceProvider const&) = delete;
@@ -81,6 +90,55 @@ namespace Rest {
          */
         InterfaceProvider& patch(std::string const& url, std::function <void(Request, Response)> callback);
 
+        /**
+         *  Registers a handler whose type is known at compile time, like a lambda or a function object.
+         *  Unlike the overloads above, there is no std::function and Request and Response are passed by reference,
+         *  so nothing is copied for the call. Dispatching costs one call through a function pointer per request,
+         *  which then calls the handler directly.
+         *
+         *  api.route("GET", "/users/:id<u64>", [](Rest::Request& req, Rest::Response& res) {...});
+         *
+         *  @param type The request type, such as "GET".
+         *  @param url The url to listen on. See the other overloads.
+         *  @param handler Called as handler(Request&, Response&). Must be callable concurrently.
+         */
+        template <typename Handler>
+        InterfaceProvider& route(std::string const& type, std::string const& url, Handler handler)
+        {
+            registerRequest(type, url, std::make_shared <Handler> (std::move(handler)), &invokeHandler <Handler>);
+            return *this;
+        }
+
+        /**
+         *  Serves the files of a directory tree under a url prefix, for GET and HEAD requests.
+         *  "/assets/css/site.css" is answered with "<directory>/css/site.css", "/assets/" with "<directory>/index.html".
+         *  Paths containing "." or ".." segments, empty segments or null bytes are answered with 404, as are missing files.
+         *  Symbolic links inside the directory are followed.
+         *
+         *  Files are sent with sendfile where available. They are kept open (see ServerSettings::openFileCacheSize)
+         *  or in memory if the FileCache is on (see ServerSettings::fileCacheSize).
+         *
+         *  @param urlPrefix The url to mount the directory on, like "/assets". "/" serves the whole url space.
+         *  @param directory The directory to serve.
+         */
+        InterfaceProvider& serveStatic(std::string const& urlPrefix, std::string const& directory);
+
+        /**
+         *  Removes all handlers registered for a request type and url.
+         *  Like registering, this may be done while the server is running. Requests that are
+         *  already being handled finish with the old routes.
+         *
+         *  @param type The request type, such as "GET".
+         *  @param url The url exactly as it was registered.
+         *
+         *  @return Whether anything was removed.
+         */
+        bool unregister(std::string const& type, std::string const& url);
+
+        /**
+         *  Starts the server. Routes can be registered before or while running.
+         *  Every server shard (see ServerMode::PerCore) gets its own copy of them.
+         */
         void start();
         void stop();
 
@@ -89,21 +147,53 @@ namespace Rest {
 
     private:
         struct BuiltRequest {
-            Url url;
-            std::function <void(Request, Response)> callback;
+            std::string type;
+            std::string url;
+            std::vector <std::string> parameterNames;
+            std::shared_ptr <void const> handler;
+            void (*invoke)(void const* handler, Request& request, Response& response);
         };
 
-        bool matching(Url received, Url registered);
-        std::unordered_map <std::string, std::string> extractParameters(Url received, Url registered);
+        /**
+         *  The compiled routes. The router finds the index into requests.
+         */
+        struct RouteTable {
+            Router router;
+            std::vector <BuiltRequest> requests;
+        };
 
     private:
         void registerRequest(std::string const& type, std::string const& url, std::function <void(Request, Response)> callback);
+        void registerRequest(std::string const& type, std::string const& url,
+                             std::shared_ptr <void const> handler, void (*invoke)(void const*, Request&, Response&));
+
+        template <typename Handler>
+        static void invokeHandler(void const* handler, Request& request, Response& response)
+        {
+            (*static_cast <Handler const*> (handler))(request, response);
+        }
+
+        static void invokeFunction(void const* handler, Request& request, Response& response);
+
+        /**
+         *  Hands the current routes to every shard. Requires routeLock_.
+         */
+        void publishRoutes();
+
+        /**
+         *  Turns the percent-encoded rest of a static url into a file name below root.
+         *
+         *  @return false if the path would leave root or is malformed.
+         */
+        static bool resolveStaticPath(std::string const& root, boost::string_view encodedPath, std::string& fileName);
 
         void connectionHandler(std::shared_ptr <RestConnection> connection);
         void errorHandler(std::shared_ptr <RestConnection> connection, InvalidRequest const& erroneousRequest);
 
     private:
         RestServer server_;
-        std::unordered_map <std::string, std::vector <BuiltRequest> > requests_;
+        std::mutex routeLock_; // serializes changes to the routes.
+        RouteTable requests_; // registered routes.
+        std::vector <std::unique_ptr <SnapshotCell <RouteTable>>> shardRequests_; // one cell per server shard, all holding the same snapshot. Made by start.
     };
 }
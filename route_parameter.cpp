@@ -0,0 +1,143 @@
+#include "route_parameter.hpp"
+
+#include <limits>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        int hexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+        /**
+         *  Parses plain decimal digits, no sign, no leading '+', no spaces.
+         */
+        bool parseDigits(boost::string_view digits, std::uint64_t limit, std::uint64_t& result)
+        {
+            if (digits.empty())
+                return false;
+
+            result = 0;
+            for (auto c : digits)
+            {
+                if (c < '0' || c > '9')
+                    return false;
+                auto digit = static_cast <std::uint64_t> (c - '0');
+                if (result > (limit - digit) / 10)
+                    return false;
+                result = result * 10 + digit;
+            }
+            return true;
+        }
+
+        bool parseSigned(boost::string_view segment, std::int64_t minimum, std::int64_t maximum, std::int64_t& result)
+        {
+            auto negative = !segment.empty() && segment.front() == '-';
+            if (negative)
+                segment.remove_prefix(1);
+
+            // the magnitude of the minimum is one more than the maximum.
+            std::uint64_t magnitude;
+            auto limit = negative ? static_cast <std::uint64_t> (-(minimum + 1)) + 1 : static_cast <std::uint64_t> (maximum);
+            if (!parseDigits(segment, limit, magnitude))
+                return false;
+
+            if (negative)
+                result = magnitude == 0 ? 0 : -static_cast <std::int64_t> (magnitude - 1) - 1;
+            else
+                result = static_cast <std::int64_t> (magnitude);
+            return true;
+        }
+
+        bool parseUuid(boost::string_view segment, Uuid& uuid)
+        {
+            if (segment.size() != 36)
+                return false;
+
+            std::size_t byte = 0;
+            for (std::size_t i = 0; i != segment.size();)
+            {
+                if (i == 8 || i == 13 || i == 18 || i == 23)
+                {
+                    if (segment[i] != '-')
+                        return false;
+                    ++i;
+                    continue;
+                }
+                auto high = hexValue(segment[i]);
+                auto low = hexValue(segment[i + 1]);
+                if (high < 0 || low < 0)
+                    return false;
+                uuid.bytes[byte++] = static_cast <std::uint8_t> (high * 16 + low);
+                i += 2;
+            }
+            return true;
+        }
+    }
+//#######################################################################################################
+    std::string Uuid::toString() const
+    {
+        static char const digits[] = "0123456789abcdef";
+
+        std::string result;
+        result.reserve(36);
+        for (std::size_t i = 0; i != bytes.size(); ++i)
+        {
+            if (i == 4 || i == 6 || i == 8 || i == 10)
+                result.push_back('-');
+            result.push_back(digits[bytes[i] >> 4]);
+            result.push_back(digits[bytes[i] & 0x0F]);
+        }
+        return result;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool parseParameterType(boost::string_view name, ParameterType& type)
+    {
+        if (name == "string")
+            type = ParameterType::String;
+        else if (name == "i32")
+            type = ParameterType::I32;
+        else if (name == "i64")
+            type = ParameterType::I64;
+        else if (name == "u32")
+            type = ParameterType::U32;
+        else if (name == "u64")
+            type = ParameterType::U64;
+        else if (name == "uuid")
+            type = ParameterType::Uuid;
+        else
+            return false;
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool convertParameter(ParameterType type, boost::string_view segment, ParameterValue& value)
+    {
+        value.type = type;
+        switch (type)
+        {
+            case ParameterType::String:
+                return true;
+            case ParameterType::I32:
+                return parseSigned(segment, std::numeric_limits <std::int32_t>::min(), std::numeric_limits <std::int32_t>::max(), value.signedInteger);
+            case ParameterType::I64:
+                return parseSigned(segment, std::numeric_limits <std::int64_t>::min(), std::numeric_limits <std::int64_t>::max(), value.signedInteger);
+            case ParameterType::U32:
+                return parseDigits(segment, std::numeric_limits <std::uint32_t>::max(), value.unsignedInteger);
+            case ParameterType::U64:
+                return parseDigits(segment, std::numeric_limits <std::uint64_t>::max(), value.unsignedInteger);
+            case ParameterType::Uuid:
+                return parseUuid(segment, value.uuid);
+        }
+        return false;
+    }
+//#######################################################################################################
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <boost/utility/string_view.hpp>
+
+#include <array>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
+namespace Rest {
+
+    /**
+     *  The type of a route parameter, written behind its name: "/users/:id<u64>".
+     *  Parameters without a type are strings.
+     */
+    enum class ParameterType : std::uint8_t
+    {
+        String, // "string", any non-empty segment.
+        I32, // "i32"
+        I64, // "i64"
+        U32, // "u32"
+        U64, // "u64"
+        Uuid // "uuid", like "123e4567-e89b-12d3-a456-426614174000", any case.
+    };
+
+    struct Uuid
+    {
+        std::array <std::uint8_t, 16> bytes;
+
+        /**
+         *  Returns the lower case canonical form.
+         */
+        std::string toString() const;
+    };
+
+    /**
+     *  A parameter converted while routing.
+     */
+    struct ParameterValue
+    {
+        ParameterType type;
+        union
+        {
+            std::int64_t signedInteger; // I32, I64
+            std::uint64_t unsignedInteger; // U32, U64
+            Uuid uuid;
+        };
+    };
+
+    /**
+     *  Looks up a type by its name in a route pattern.
+     *
+     *  @return false if there is no type of that name.
+     */
+    bool parseParameterType(boost::string_view name, ParameterType& type);
+
+    /**
+     *  Converts a path segment. Numbers are plain decimal digits, with a leading '-' for signed types.
+     *
+     *  @return false if the segment is not of the type or out of its range.
+     */
+    bool convertParameter(ParameterType type, boost::string_view segment, ParameterValue& value);
+
+    /**
+     *  Tells how to get a C++ type out of a parameter. Specialized for every supported type.
+     */
+    template <typename T>
+    struct ParameterTraits;
+
+    template <>
+    struct ParameterTraits <std::string>
+    {
+        static constexpr ParameterType type = ParameterType::String;
+        static std::string get(boost::string_view segment, ParameterValue const&) { return segment.to_string(); }
+    };
+
+    template <>
+    struct ParameterTraits <boost::string_view>
+    {
+        static constexpr ParameterType type = ParameterType::String;
+        static boost::string_view get(boost::string_view segment, ParameterValue const&) { return segment; }
+    };
+
+    template <>
+    struct ParameterTraits <std::int32_t>
+    {
+        static constexpr ParameterType type = ParameterType::I32;
+        static std::int32_t get(boost::string_view, ParameterValue const& value) { return static_cast <std::int32_t> (value.signedInteger); }
+    };
+
+    template <>
+    struct ParameterTraits <std::int64_t>
+    {
+        static constexpr ParameterType type = ParameterType::I64;
+        static std::int64_t get(boost::string_view, ParameterValue const& value) { return value.signedInteger; }
+    };
+
+    template <>
+    struct ParameterTraits <std::uint32_t>
+    {
+        static constexpr ParameterType type = ParameterType::U32;
+        static std::uint32_t get(boost::string_view, ParameterValue const& value) { return static_cast <std::uint32_t> (value.unsignedInteger); }
+    };
+
+    template <>
+    struct ParameterTraits <std::uint64_t>
+    {
+        static constexpr ParameterType type = ParameterType::U64;
+        static std::uint64_t get(boost::string_view, ParameterValue const& value) { return value.unsignedInteger; }
+    };
+
+    template <>
+    struct ParameterTraits <Uuid>
+    {
+        static constexpr ParameterType type = ParameterType::Uuid;
+        static Uuid get(boost::string_view, ParameterValue const& value) { return value.uuid; }
+    };
+
+    /**
+     *  Gets a parameter as T. If the route declared it as T already, the value converted while routing is used,
+     *  otherwise the segment is converted now.
+     *
+     *  @throw std::invalid_argument if the segment cannot be converted to T.
+     */
+    template <typename T>
+    T extractParameter(boost::string_view segment, ParameterValue const& value)
+    {
+        using traits = ParameterTraits <T>;
+        if (value.type == traits::type)
+            return traits::get(segment, value);
+
+        ParameterValue converted;
+        if (!convertParameter(traits::type, segment, converted))
+            throw std::invalid_argument("Parameter cannot be converted: " + segment.to_string());
+        return traits::get(segment, converted);
+    }
+
+} // namespace Rest
@@ -0,0 +1,214 @@
+#include "router.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Rest
+{
+//#######################################################################################################
+    namespace
+    {
+        /**
+         *  Splits off the first segment of a path starting with '/'.
+         *  The rest starts with '/' again, or is empty.
+         */
+        boost::string_view nextSegment(boost::string_view& path)
+        {
+            auto end = path.find('/', 1);
+            auto segment = path.substr(1, end == boost::string_view::npos ? boost::string_view::npos : end - 1);
+            path = end == boost::string_view::npos ? boost::string_view{} : path.substr(end);
+            return segment;
+        }
+
+        /**
+         *  Splits ":name<type>" into name and type.
+         */
+        ParameterType parseParameter(boost::string_view segment, std::string& name)
+        {
+            auto open = segment.find('<');
+            if (open == boost::string_view::npos)
+            {
+                name = segment.substr(1).to_string();
+                return ParameterType::String;
+            }
+
+            ParameterType type;
+            if (segment.back() != '>' || !parseParameterType(segment.substr(open + 1, segment.size() - open - 2), type))
+                throw std::invalid_argument("Unknown parameter type in route segment: " + segment.to_string());
+            name = segment.substr(1, open - 1).to_string();
+            return type;
+        }
+
+        bool segmentLess(std::pair <std::string, std::uint32_t> const& entry, boost::string_view segment)
+        {
+            return boost::string_view{entry.first} < segment;
+        }
+    }
+//#######################################################################################################
+    constexpr std::size_t Router::maxParameters;
+    constexpr std::uint32_t Router::none;
+//-------------------------------------------------------------------------------------------------------
+    Router::Router()
+        : nodes_()
+        , roots_()
+    {
+
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::uint32_t Router::addNode()
+    {
+        nodes_.emplace_back();
+        return static_cast <std::uint32_t> (nodes_.size() - 1);
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::uint32_t Router::addParameter(std::uint32_t node, ParameterType type)
+    {
+        auto& parameters = nodes_[node].parameters;
+        for (auto const& parameter : parameters)
+        {
+            if (parameter.first == type)
+                return parameter.second;
+        }
+
+        // typed parameters are tried before strings, which match anything.
+        auto position = std::end(parameters) - std::begin(parameters);
+        if (type != ParameterType::String && !parameters.empty() && parameters.back().first == ParameterType::String)
+            --position;
+
+        auto child = addNode(); // invalidates parameters.
+        auto& grown = nodes_[node].parameters;
+        grown.emplace(std::begin(grown) + position, type, child);
+        return child;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::uint32_t Router::getRoot(boost::string_view method) const
+    {
+        for (auto const& root : roots_)
+        {
+            if (root.first == method)
+                return root.second;
+        }
+        return none;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool Router::hasMethod(boost::string_view method) const
+    {
+        return getRoot(method) != none;
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::vector <std::string> Router::add(boost::string_view method, boost::string_view pattern, std::size_t route)
+    {
+        if (pattern.empty() || pattern.front() != '/')
+            throw std::invalid_argument("Route must start with '/': " + pattern.to_string());
+
+        auto node = getRoot(method);
+        if (node == none)
+        {
+            node = addNode();
+            roots_.emplace_back(method.to_string(), node);
+        }
+
+        std::vector <std::string> names;
+        if (pattern == "/")
+            pattern = {};
+
+        while (!pattern.empty())
+        {
+            auto segment = nextSegment(pattern);
+            if (!segment.empty() && segment.front() == '*')
+            {
+                if (!pattern.empty())
+                    throw std::invalid_argument("A wildcard must be the last segment of a route.");
+                names.push_back(segment.size() == 1 ? "*" : segment.substr(1).to_string());
+                if (names.size() > maxParameters)
+                    throw std::invalid_argument("Route has too many parameters.");
+                if (nodes_[node].wildcardRoute == none)
+                    nodes_[node].wildcardRoute = static_cast <std::uint32_t> (route);
+                return names;
+            }
+
+            if (!segment.empty() && segment.front() == ':')
+            {
+                std::string name;
+                auto type = parseParameter(segment, name);
+                names.push_back(std::move(name));
+                if (names.size() > maxParameters)
+                    throw std::invalid_argument("Route has too many parameters.");
+                node = addParameter(node, type);
+                continue;
+            }
+
+            auto& statics = nodes_[node].statics;
+            auto entry = std::lower_bound(std::begin(statics), std::end(statics), segment, segmentLess);
+            if (entry != std::end(statics) && entry->first == segment)
+            {
+                node = entry->second;
+                continue;
+            }
+
+            auto position = entry - std::begin(statics);
+            auto child = addNode(); // invalidates statics.
+            auto& grown = nodes_[node].statics;
+            grown.emplace(std::begin(grown) + position, segment.to_string(), child);
+            node = child;
+        }
+
+        if (nodes_[node].route == none)
+            nodes_[node].route = static_cast <std::uint32_t> (route);
+        return names;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool Router::find(boost::string_view method, boost::string_view path, Match& match) const
+    {
+        auto root = getRoot(method);
+        if (root == none)
+            return false;
+
+        match.parameterCount = 0;
+        if (path == "/")
+            path = {};
+        return matchNode(root, path, match);
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool Router::matchNode(std::uint32_t index, boost::string_view path, Match& match) const
+    {
+        auto const& node = nodes_[index];
+        if (path.empty())
+        {
+            if (node.route == none)
+                return false;
+            match.route = node.route;
+            return true;
+        }
+
+        auto rest = path;
+        auto segment = nextSegment(rest);
+
+        auto entry = std::lower_bound(std::begin(node.statics), std::end(node.statics), segment, segmentLess);
+        if (entry != std::end(node.statics) && entry->first == segment && matchNode(entry->second, rest, match))
+            return true;
+
+        if (!segment.empty() && match.parameterCount < maxParameters)
+        {
+            for (auto const& parameter : node.parameters)
+            {
+                if (!convertParameter(parameter.first, segment, match.values[match.parameterCount]))
+                    continue;
+                match.parameters[match.parameterCount++] = segment;
+                if (matchNode(parameter.second, rest, match))
+                    return true;
+                --match.parameterCount;
+            }
+        }
+
+        if (node.wildcardRoute != none && path.size() > 1 && match.parameterCount < maxParameters)
+        {
+            match.values[match.parameterCount].type = ParameterType::String;
+            match.parameters[match.parameterCount++] = path.substr(1);
+            match.route = node.wildcardRoute;
+            return true;
+        }
+        return false;
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "route_parameter.hpp"
+
+#include <boost/utility/string_view.hpp>
+
+#include <array>
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  Maps request methods and paths to routes.
+     *  Route patterns are compiled into a segment trie per method when they are added,
+     *  so finding a route takes one step per path segment and does not allocate.
+     *
+     *  Pattern segments are matched in this order of priority:
+     *  - Static segments, like "users".
+     *  - Typed parameters, like ":id<u64>". They match segments that convert to the type, see ParameterType.
+     *    Different types at the same position are tried in the order they were added.
+     *  - Parameters, like ":id". They match any non-empty segment and capture it.
+     *  - A wildcard "*" or "*name" as the last segment, matching the non-empty rest of the path.
+     *  A request that fails to match further down a static branch falls back to the parameter branch, and so on.
+     */
+    class Router
+    {
+    public:
+        static constexpr std::size_t maxParameters = 16;
+
+        struct Match
+        {
+            std::size_t route = 0;
+            std::array <boost::string_view, maxParameters> parameters; // views into the path, in pattern order.
+            std::array <ParameterValue, maxParameters> values; // parameters converted to their declared type.
+            std::size_t parameterCount = 0;
+        };
+
+        Router();
+
+        /**
+         *  Adds a route. If the same pattern is added twice for a method, the first one stays.
+         *
+         *  @param method The request method, like "GET".
+         *  @param pattern The path pattern, like "/users/:id<u64>/files". See above for wildcards.
+         *  @param route An identifier returned by find.
+         *
+         *  @throw std::invalid_argument for broken patterns and unknown parameter types.
+         *
+         *  @return The parameter names in pattern order, "*" for an unnamed wildcard.
+         */
+        std::vector <std::string> add(boost::string_view method, boost::string_view pattern, std::size_t route);
+
+        /**
+         *  Finds the route for a path.
+         *
+         *  @param path The path part of the request target, still percent-encoded.
+         *  @param match Receives the route and the captured parameters.
+         *
+         *  @return false if there is no matching route.
+         */
+        bool find(boost::string_view method, boost::string_view path, Match& match) const;
+
+        /**
+         *  Returns whether any route was added for the method.
+         */
+        bool hasMethod(boost::string_view method) const;
+
+    private:
+        static constexpr std::uint32_t none = 0xFFFFFFFF;
+
+        struct Node
+        {
+            std::vector <std::pair <std::string, std::uint32_t>> statics; // sorted by segment.
+            std::vector <std::pair <ParameterType, std::uint32_t>> parameters; // child node per parameter type, strings last.
+            std::uint32_t route = none; // route ending here.
+            std::uint32_t wildcardRoute = none; // route with a wildcard following here.
+        };
+
+        std::uint32_t getRoot(boost::string_view method) const;
+        std::uint32_t addNode();
+        std::uint32_t addParameter(std::uint32_t node, ParameterType type);
+        bool matchNode(std::uint32_t node, boost::string_view path, Match& match) const;
+
+    private:
+        std::vector <Node> nodes_; // nodes refer to each other by index, so copying the router needs no fixups.
+        std::vector <std::pair <std::string, std::uint32_t>> roots_; // root node per method.
+    };
+
+} // namespace Rest
@@ -1,6 +1,15 @@
 #include "server.hpp"
 #include "io_service_provider.hpp"
 #include "connection.hpp"
+
+#include <algorithm>
+#include <future>
+#include <cstring>
+
+#ifdef __linux__
+#   include <pthread.h>
+#   include <sched.h>
+#endif
 
 // REMOVE ME
 #include <iostream>
@@ -11,16 +20,15 @@ namespace Rest
 {
 //#######################################################################################################
     RestServer::RestServer(std::function <void(std::shared_ptr <RestConnection>)> handler,
-                           std::function <void(std::shared_ptr <RestConnection>, InvalidRequest const&)> errorHandler, uint16_t port)
+                           std::function <void(std::shared_ptr <RestConnection>, InvalidRequest const&)> errorHandler, uint16_t port,
+                           ServerSettings const& settings)
         : endpoint_(tcp::v4(), port)
-        , acceptor_(nullptr)
+        , shards_()
         , handler_(handler)
         , errorHandler_(errorHandler)
-        , acceptingThread_()
+        , settings_(settings)
+        , workers_(nullptr)
         , listening_(false)
-        , idIncrement_(0)
-        , memberLock_()
-        , connections_()
     {
 
     }
@@ -28,75 +36,272 @@ namespace Rest
     RestServer::~RestServer()
     {
         // running? -> stop!
-        if (acceptingThread_.joinable())
+        if (listening_.load())
             stop();
     }
 //-------------------------------------------------------------------------------------------------------
     void RestServer::start()
     {
-        acceptor_.reset(new tcp::acceptor(IOServiceProvider::getInstance().getIOService(), endpoint_));
-
         // is currently running, stop first
-        if (acceptingThread_.joinable())
+        if (listening_.load())
             stop();
 
+        openShards();
+
+        if (settings_.mode == ServerMode::Threaded)
+        {
+            auto workerCount = settings_.workerCount;
+            if (workerCount == 0)
+                workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+            workers_.reset(new WorkerPool(workerCount, settings_.queueDepth, [this](RestConnection* connection) {
+                serve(connection);
+            }));
+
+            // a single io thread is enough for accepting.
+            IOServiceProvider::getInstance().acquireThreads(1);
+        }
+        else if (settings_.mode == ServerMode::Asynchronous)
+            IOServiceProvider::getInstance().acquireThreads(settings_.ioThreadCount);
+
         listening_.store(true);
-        acceptingThread_ = std::thread([this]() {
-            for (;listening_.load();)
+        for (auto& shard : shards_)
+            accept(*shard);
+
+        if (settings_.mode == ServerMode::PerCore)
+        {
+            auto cpuCount = std::max(std::thread::hardware_concurrency(), 1u);
+            for (auto& shard : shards_)
             {
-                idIncrement_.store(idIncrement_.load() + 1);
-                std::shared_ptr <RestConnection> connection (new RestConnection(this, idIncrement_.load()));
-                boost::system::error_code ec;
-                boost::asio::ip::tcp::acceptor::endpoint_type remoteEndpoint;
-                acceptor_->accept(*connection->getStream().rdbuf(), remoteEndpoint, ec);
+                auto* service = shard->service;
+                shard->thread = std::thread([service]() { service->run(); });
+#ifdef __linux__
+                if (settings_.pinThreads)
+                {
+                    cpu_set_t cpus;
+                    CPU_ZERO(&cpus);
+                    CPU_SET(shard->index % cpuCount, &cpus);
+                    auto result = pthread_setaffinity_np(shard->thread.native_handle(), sizeof(cpus), &cpus);
+                    if (result != 0)
+                        std::cerr << "Could not pin shard " << shard->index << " to core " << shard->index % cpuCount << ": " << std::strerror(result) << "\n";
+                }
+#else
+                (void)cpuCount;
+#endif
+            }
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    std::size_t RestServer::getShardCount() const
+    {
+        if (settings_.mode != ServerMode::PerCore)
+            return 1;
+#ifdef SO_REUSEPORT
+        if (settings_.ioThreadCount != 0)
+            return settings_.ioThreadCount;
+        return std::max(std::thread::hardware_concurrency(), 1u);
+#else
+        return 1;
+#endif
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestServer::openShards()
+    {
+        shards_.clear();
+        for (std::size_t i = 0; i != getShardCount(); ++i)
+        {
+            std::unique_ptr <Shard> shard (new Shard{i, nullptr, nullptr, nullptr, nullptr, nullptr, std::thread{}, i + 1});
+            if (settings_.mode == ServerMode::PerCore)
+            {
+                shard->ownService.reset(new boost::asio::io_service(1));
+                shard->service = shard->ownService.get();
+                shard->work.reset(new boost::asio::io_service::work(*shard->service));
+            }
+            else
+                shard->service = &IOServiceProvider::getInstance().getIOService();
+
+            shard->acceptor.reset(new tcp::acceptor(*shard->service));
+            shard->acceptor->open(endpoint_.protocol());
+            shard->acceptor->set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+            if (settings_.mode == ServerMode::PerCore)
+            {
+                // every core binds the same port, the kernel distributes the connections.
+                using reuse_port = boost::asio::detail::socket_option::boolean <SOL_SOCKET, SO_REUSEPORT>;
+                shard->acceptor->set_option(reuse_port(true));
+            }
+#endif
+            shard->acceptor->bind(endpoint_);
+            shard->acceptor->listen();
+            shard->strand.reset(new boost::asio::io_service::strand(*shard->service));
+
+            // every shard caches the files it serves itself, with an equal part of the capacity.
+            auto shardCount = getShardCount();
+            if (settings_.fileCacheSize != 0)
+                shard->fileCache.reset(new FileCache(settings_.fileCacheSize / shardCount, settings_.fileCacheMaxFileSize));
+#ifndef _WIN32
+            shard->openFiles.reset(new OpenFileCache(std::max <std::size_t> (1, settings_.openFileCacheSize / shardCount)));
+#endif
+            shards_.push_back(std::move(shard));
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestServer::accept(Shard& shard)
+    {
+        auto id = shard.nextId;
+        shard.nextId += shards_.size();
+        std::shared_ptr <RestConnection> connection (new RestConnection(this, id, *shard.service, shard.index));
+        shard.acceptor->async_accept(connection->socket_, connection->endpoint_, shard.strand->wrap(
+            [this, connection, &shard](boost::system::error_code const& ec)
+            {
+                if (!listening_.load())
+                    return;
+
                 if (!ec)
                 {
-                    connection->setEndpoint(remoteEndpoint);
                     // LOCK_SCOPE
                     {
-                        std::lock_guard <std::mutex> guard (memberLock_);
-                        connections_.insert({connection->getId(), connection});
+                        std::lock_guard <std::mutex> guard (shard.lock);
+                        shard.connections.insert({connection->getId(), connection});
+                    }
+
+                    // threaded connections get a worker once the first request arrives.
+                    if (settings_.mode != ServerMode::Threaded)
+                        connection->start();
+                    else
+                    {
+                        connection->headDeadline_ = std::chrono::steady_clock::now() + settings_.idleTimeout;
+                        connection->waitForHeadAsync();
                     }
-                    std::thread([connection, this](){
-                        try {
-                            connection->readHead();
-                            handler_(connection);
-                        } catch (InvalidRequest const& exc) {
-                            errorHandler_(connection, exc);
-                        }
-                        catch (std::exception const& exc) {
-                            std::cerr << "BAD ERROR: " << exc.what() << "\n";
-                            std::terminate();
-                            // std::terminate - do not handle unexpected exceptions.
-                            // we don't wanna catch our programming errors ;)
-                        }
-                        connection->free();
-                    }).detach();
                 }
+                accept(shard);
             }
-        });
+        ));
     }
 //-------------------------------------------------------------------------------------------------------
     void RestServer::stop()
     {
-        // dont touch the ordering. Everything else deadlock
-        try {
-            acceptor_.reset();
-        } catch (std::exception const&) {
+        if (!listening_.exchange(false))
+            return;
 
+        // close the acceptors on their strands, so that no accept handler runs at the same time.
+        for (auto& shard : shards_)
+        {
+            std::promise <void> closed;
+            auto* acceptor = shard->acceptor.get();
+            shard->strand->post([acceptor, &closed]() {
+                boost::system::error_code ec;
+                acceptor->close(ec);
+                closed.set_value();
+            });
+            closed.get_future().wait();
+        }
+
+        // pending operations complete with an error and the connections remove themselves.
+        // Threaded connections are only closed while they wait for a request, running handlers finish.
+        for (auto& shard : shards_)
+        {
+            std::lock_guard <std::mutex> guard (shard->lock);
+            for (auto& connection : shard->connections)
+            {
+                if (settings_.mode != ServerMode::Threaded)
+                    connection.second->close();
+                else
+                    connection.second->closeIfWaiting();
+            }
+        }
+
+        // connections that never got a worker are dropped.
+        if (workers_)
+        {
+            workers_->stop([](RestConnection* connection) {
+                connection->free();
+            });
         }
-        listening_.store(false);
 
-        if (acceptingThread_.joinable())
-            acceptingThread_.join();
+        // waiting threaded connections come back through resume, so the workers are destroyed afterwards.
+        for (auto& shard : shards_)
+        {
+            std::unique_lock <std::mutex> guard (shard->lock);
+            auto* connections = &shard->connections;
+            shard->drained.wait(guard, [connections]() { return connections->empty(); });
+        }
+        workers_.reset();
+
+        if (settings_.mode == ServerMode::PerCore)
+        {
+            for (auto& shard : shards_)
+            {
+                shard->work.reset();
+                if (shard->thread.joinable())
+                    shard->thread.join();
+            }
+        }
+        else
+            IOServiceProvider::getInstance().releaseThreads();
+
+        shards_.clear();
     }
 //-------------------------------------------------------------------------------------------------------
     void RestServer::deregisterClient(RestConnection* connection)
     {
         // remove a client from the list to make it available for deletion.
-        std::lock_guard <std::mutex> guard (memberLock_);
+        auto& shard = *shards_[connection->getShard()];
+        std::lock_guard <std::mutex> guard (shard.lock);
 
-        connections_.erase(connection->getId());
+        shard.connections.erase(connection->getId());
+        if (shard.connections.empty())
+            shard.drained.notify_all();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestServer::handle(std::shared_ptr <RestConnection> const& connection)
+    {
+        try {
+            handler_(connection);
+        } catch (InvalidRequest const& exc) {
+            handleError(connection, exc);
+        }
+        catch (std::exception const& exc) {
+            std::cerr << "BAD ERROR: " << exc.what() << "\n";
+            std::terminate();
+            // std::terminate - do not handle unexpected exceptions.
+            // we don't wanna catch our programming errors ;)
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestServer::handleError(std::shared_ptr <RestConnection> const& connection, InvalidRequest const& error)
+    {
+        errorHandler_(connection, error);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestServer::serve(RestConnection* connection)
+    {
+        // the connection is kept alive by its shard until free() is called.
+        auto shared = connection->shared_from_this();
+        do {
+            try {
+                auto state = shared->readHead();
+                if (state == RestConnection::HeadState::Closed)
+                    break;
+                if (state == RestConnection::HeadState::Incomplete)
+                {
+                    // the worker is free for others while the client takes its time.
+                    shared->output_.commit();
+                    shared->waitForHeadAsync();
+                    return;
+                }
+                handle(shared);
+            } catch (InvalidRequest const& exc) {
+                handleError(shared, exc);
+            }
+        } while (shared->finishRequest());
+        shared->output_.commit();
+        shared->free();
+    }
+//-------------------------------------------------------------------------------------------------------
+    void RestServer::resume(RestConnection* connection)
+    {
+        if (!listening_.load() || !workers_->push(connection))
+            connection->free();
     }
 //#######################################################################################################
 } // namespace Rest
@@ -3,15 +3,21 @@
 #include "forward.hpp"
 #include "user_id.hpp"
 #include "exceptions.hpp"
+#include "server_settings.hpp"
+#include "worker_pool.hpp"
+#include "file_cache.hpp"
+#include "open_file_cache.hpp"
 
 #include <boost/asio.hpp>
 
 #include <functional>
 #include <unordered_map>
+#include <vector>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
 
 namespace Rest {
 
@@ -33,9 +39,12 @@ namespace Rest {
          *  @param errorHandler A handler called when a request is bad.
          *
          *  @param port The port to bind on.
+         *
+         *  @param settings Worker pool size, queue depth, etc. See ServerSettings.
          */
         RestServer(std::function <void(std::shared_ptr <RestConnection>)> handler,
-                   std::function <void(std::shared_ptr <RestConnection>, InvalidRequest const&)> errorHandler, uint16_t port = 80);
+                   std::function <void(std::shared_ptr <RestConnection>, InvalidRequest const&)> errorHandler, uint16_t port = 80,
+                   ServerSettings const& settings = {});
 
         /**
          *  Deconstructor. Automatically destroys all connections. Beware!
@@ -50,29 +59,90 @@ namespace Rest {
         void start();
 
         /**
-         *  Stops the server. Please make sure to finish off all clients or this might lead to std::terminate.
+         *  Stops the server. Lets running handlers finish.
+         *  Asynchronous connections are closed, queued connections are dropped.
+         *  Must not be called from within a handler.
          */
         void stop();
 
+        /**
+         *  Returns the amount of shards the server serves on.
+         *  That is the amount of cores in ServerMode::PerCore and 1 otherwise.
+         */
+        std::size_t getShardCount() const;
+
     private:
+        /**
+         *  An acceptor together with the io service it runs on and the connections it accepted.
+         *  There is one per core in ServerMode::PerCore and just one otherwise.
+         *  Shards share no mutable state, so accepting, closing and caching files on one core does not contend with the others.
+         */
+        struct Shard
+        {
+            std::size_t index;
+            std::unique_ptr <boost::asio::io_service> ownService; // PerCore only, otherwise the provider's service is used.
+            boost::asio::io_service* service;
+            std::unique_ptr <boost::asio::io_service::work> work; // PerCore only
+            std::unique_ptr <boost::asio::ip::tcp::acceptor> acceptor; // acceptor accepting connections
+            std::unique_ptr <boost::asio::io_service::strand> strand; // serializes accept handlers and closing the acceptor.
+            std::thread thread; // PerCore only
+            std::uint64_t nextId; // only used by accept on the strand. Ids step by the shard count, so they are unique across shards.
+            std::mutex lock; // guards connections.
+            std::condition_variable drained; // signaled when the last connection of the shard is gone.
+            std::unordered_map <UserId, std::shared_ptr <RestConnection>, UserIdHasher> connections; // all currently connected peers of the shard.
+            std::unique_ptr <FileCache> fileCache; // nullptr if turned off in the settings.
+#ifndef _WIN32
+            std::unique_ptr <OpenFileCache> openFiles; // files served from static directories.
+#endif
+        };
+
+        /**
+         *  Opens the shards and their acceptors.
+         */
+        void openShards();
+
+        /**
+         *  Starts accepting the next connection on a shard.
+         */
+        void accept(Shard& shard);
+
+        /**
+         *  Calls the handler, turning InvalidRequest exceptions into calls to the error handler.
+         */
+        void handle(std::shared_ptr <RestConnection> const& connection);
+
+        /**
+         *  Calls the error handler.
+         */
+        void handleError(std::shared_ptr <RestConnection> const& connection, InvalidRequest const& error);
+
         /**
          *  called by connection to deregister itself.
          */
         void deregisterClient(RestConnection* connection);
 
+        /**
+         *  Runs on a worker thread. Serves requests until the connection is closed,
+         *  or parks it until more of the next request arrives. (Threaded mode)
+         */
+        void serve(RestConnection* connection);
+
+        /**
+         *  Queues a parked connection for a worker again, see RestConnection::waitForHeadAsync. (Threaded mode)
+         */
+        void resume(RestConnection* connection);
+
     private:
         boost::asio::ip::tcp::endpoint endpoint_; // socket endpoint
-        std::unique_ptr <boost::asio::ip::tcp::acceptor> acceptor_; // acceptor accepting connections
+        std::vector <std::unique_ptr <Shard>> shards_; // acceptors, connections and file caches, see Shard.
 
         std::function <void(std::shared_ptr <RestConnection>)> handler_; // handler callback for connections.
         std::function <void(std::shared_ptr <RestConnection>, InvalidRequest const&)> errorHandler_; // handler for invalid requests.
 
-        std::thread acceptingThread_; // acceptor thread
-        std::atomic_bool listening_; // listening flag = server is bound?
-        std::atomic <uint64_t> idIncrement_; // auto increment for ids. overflow is only an issue if the first connections still exists after 256**8 connections have gone through.
-        std::mutex memberLock_; // thread protection
+        ServerSettings settings_; // pool size, queue depth, ...
+        std::unique_ptr <WorkerPool> workers_; // threads serving accepted connections.
 
-        std::unordered_map <UserId, std::shared_ptr <RestConnection>, UserIdHasher> connections_; // all currently connected peers.
+        std::atomic_bool listening_; // listening flag = server is bound?
     };
 
 } // namespace Rest
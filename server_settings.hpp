@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+#include <limits>
+#include <string>
+
+namespace Rest {
+
+    /**
+     *  How a RestServer serves its connections.
+     */
+    enum class ServerMode
+    {
+        /**
+         *  Requests are served by the threads of a worker pool, using blocking socket operations.
+         *  Connections waiting for their next request are watched by the io service and hold no worker.
+         */
+        Threaded,
+
+        /**
+         *  Accept, head read, body read and response write are asynchronous operations
+         *  run by a few io service threads. Handlers are called on these threads.
+         *  Responses are collected in memory and written once the handler returns, files from the FileCache
+         *  or with sendfile, so a slow client holds no thread. Two things still block the io thread:
+         *  bodies larger than asyncBodyLimit (or chunked ones) that the handler reads, and streamed responses.
+         */
+        Asynchronous,
+
+        /**
+         *  Asynchronous, but shared nothing. Every core gets its own SO_REUSEPORT acceptor,
+         *  io service, thread and copy of the routes. A connection is served start to finish
+         *  on the core the kernel assigned it to.
+         *  Falls back to a single core where SO_REUSEPORT is not available.
+         */
+        PerCore
+    };
+
+    /**
+     *  Tuning knobs for a RestServer.
+     *  The defaults are reasonable for most applications.
+     */
+    struct ServerSettings
+    {
+        /**
+         *  Threaded or asynchronous. See ServerMode.
+         */
+        ServerMode mode = ServerMode::Threaded;
+
+        /**
+         *  Number of worker threads that serve accepted connections. (Threaded mode)
+         *  0 picks std::thread::hardware_concurrency().
+         */
+        std::size_t workerCount = 0;
+
+        /**
+         *  Maximum number of accepted connections that may wait for a free worker. (Threaded mode)
+         *  The server stops accepting while the queue is full.
+         */
+        std::size_t queueDepth = 1024;
+
+        /**
+         *  Number of threads calling run() on the io service. (Asynchronous mode)
+         *  Number of cores to serve on. (PerCore mode)
+         *  0 picks std::thread::hardware_concurrency().
+         */
+        std::size_t ioThreadCount = 0;
+
+        /**
+         *  Pins every core's thread to its own CPU. (PerCore mode, Linux only)
+         */
+        bool pinThreads = false;
+
+        /**
+         *  Bodies up to this size are read asynchronously before the handler is called. (Asynchronous and PerCore mode)
+         *  The handler reads larger and chunked bodies with blocking reads, occupying its io thread while doing so,
+         *  at most bodyTimeout per wait for the client.
+         */
+        std::size_t asyncBodyLimit = 1024 * 1024;
+
+        /**
+         *  Requests announcing a larger Content-Length, or sending more in chunks, are answered with 413 (Payload Too Large).
+         */
+        std::size_t maxBodySize = std::numeric_limits <std::size_t>::max();
+
+        /**
+         *  Maximum size of the request line and header fields. Also limits the trailer of chunked bodies.
+         */
+        std::size_t maxHeaderSize = 65536;
+
+        /**
+         *  Serve more than one request per connection, if the client asks for it.
+         *  HTTP/1.1 connections persist unless "Connection: close" is sent,
+         *  HTTP/1.0 connections only with "Connection: keep-alive".
+         */
+        bool keepAlive = true;
+
+        /**
+         *  Maximum amount of requests served on a single connection.
+         */
+        std::size_t maxKeepAliveRequests = 100;
+
+        /**
+         *  Pipelined requests (sent without waiting for the previous response) are answered
+         *  strictly in order. While further requests are already received, their responses are
+         *  collected and sent together, at most this many at once.
+         */
+        std::size_t maxPipelinedRequests = 16;
+
+        /**
+         *  A connection waiting longer than this for the next request head is closed.
+         *  In threaded mode the waiting connection does not occupy a worker, it only gets one once the head has arrived.
+         */
+        std::chrono::milliseconds idleTimeout = std::chrono::seconds(5);
+
+        /**
+         *  A client that stops sending in the middle of a body that is read before the handler runs
+         *  gets a 408 (Request Timeout) after this long. (Asynchronous and PerCore mode)
+         *  Body reads from within handlers pass their own timeout, which is limited to this one in these modes.
+         */
+        std::chrono::milliseconds bodyTimeout = std::chrono::seconds(3);
+
+        /**
+         *  Keeps up to this many bytes of files sent with sendFile in memory. 0 turns the cache off.
+         *  Cached files are checked for changes at most once per second. See FileCache.
+         *  In ServerMode::PerCore every core has a cache of its own with an equal part of this size.
+         */
+        std::size_t fileCacheSize = 0;
+
+        /**
+         *  Larger files are not cached, but sent from disk each time.
+         *  Files larger than the cache (or its part per core) are never cached. Up to that, the cache uses fewer shards
+         *  so that a file of this size still fits into one.
+         */
+        std::size_t fileCacheMaxFileSize = 1024 * 1024;
+
+        /**
+         *  Files served by InterfaceProvider::serveStatic are kept open, at most this many.
+         *  In ServerMode::PerCore every core keeps an equal part of them open.
+         *  Not available on Windows.
+         */
+        std::size_t openFileCacheSize = 1024;
+
+        /**
+         *  Adds a Date field to every response, unless the handler sets one.
+         *  The value is formatted at most once per second and shared by all connections.
+         */
+        bool sendDate = true;
+
+        /**
+         *  The value of a Server field added to every response, unless the handler sets one.
+         *  Empty for no Server field.
+         */
+        std::string serverName;
+    };
+
+} // namespace Rest
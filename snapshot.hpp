@@ -0,0 +1,157 @@
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  The reference counted part of a published snapshot.
+     *  Lets holders keep a snapshot alive without knowing what it contains.
+     */
+    class SnapshotBase
+    {
+    public:
+        SnapshotBase()
+            : references_(0)
+        {
+        }
+
+        virtual ~SnapshotBase() = default;
+
+        SnapshotBase(SnapshotBase const&) = delete;
+        SnapshotBase& operator=(SnapshotBase const&) = delete;
+
+        friend void intrusive_ptr_add_ref(SnapshotBase const* snapshot)
+        {
+            snapshot->references_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        friend void intrusive_ptr_release(SnapshotBase const* snapshot)
+        {
+            if (snapshot->references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete snapshot;
+        }
+
+    private:
+        mutable std::atomic <std::size_t> references_;
+    };
+
+    /**
+     *  Holds an immutable value that is read by many threads and replaced by a few, RCU style.
+     *
+     *  Readers acquire the current snapshot without locks or waiting: They announce themselves in one of two
+     *  counters, take a reference to the snapshot and leave again. The snapshot stays alive as long as they hold it.
+     *  Writers publish a complete new value. They wait only for readers that are between loading the old
+     *  pointer and referencing it, a few instructions, so publishing from within a reader is fine.
+     */
+    template <typename T>
+    class SnapshotCell
+    {
+    public:
+        class Snapshot : public SnapshotBase
+        {
+        public:
+            explicit Snapshot(T value)
+                : value_(std::move(value))
+            {
+            }
+
+            T const& get() const
+            {
+                return value_;
+            }
+
+        private:
+            T value_;
+        };
+
+        using Handle = boost::intrusive_ptr <Snapshot const>;
+
+        /**
+         *  Makes a snapshot that can be published to several cells, which then share it.
+         */
+        static Handle makeSnapshot(T value)
+        {
+            return Handle {new Snapshot(std::move(value))};
+        }
+
+        explicit SnapshotCell(T initial)
+            : SnapshotCell(makeSnapshot(std::move(initial)))
+        {
+        }
+
+        explicit SnapshotCell(Handle initial)
+            : current_(initial.get())
+            , epoch_(0)
+            , acquiring_()
+            , publishLock_()
+        {
+            intrusive_ptr_add_ref(current_.load());
+            acquiring_[0].store(0);
+            acquiring_[1].store(0);
+        }
+
+        ~SnapshotCell()
+        {
+            intrusive_ptr_release(current_.load());
+        }
+
+        SnapshotCell(SnapshotCell const&) = delete;
+        SnapshotCell& operator=(SnapshotCell const&) = delete;
+
+        /**
+         *  Returns the current value. Lock free, the value does not change while it is held.
+         */
+        Handle acquire() const
+        {
+            auto& acquiring = acquiring_[epoch_.load() & 1];
+            acquiring.fetch_add(1);
+            Handle snapshot {current_.load()};
+            acquiring.fetch_sub(1);
+            return snapshot;
+        }
+
+        /**
+         *  Replaces the value. The old one is destroyed once the last reader lets go of it.
+         */
+        void publish(T value)
+        {
+            publish(makeSnapshot(std::move(value)));
+        }
+
+        /**
+         *  Replaces the value by a snapshot that may be published to other cells as well.
+         */
+        void publish(Handle snapshot)
+        {
+            auto next = snapshot.get();
+            intrusive_ptr_add_ref(next);
+
+            std::lock_guard <std::mutex> guard {publishLock_};
+            auto previous = current_.exchange(next);
+
+            // a reader may have loaded the previous pointer, but not referenced it yet.
+            // flipping twice covers readers that picked their counter before an earlier flip.
+            for (int flip = 0; flip != 2; ++flip)
+            {
+                auto& acquiring = acquiring_[epoch_.fetch_add(1) & 1];
+                while (acquiring.load() != 0)
+                    std::this_thread::yield();
+            }
+            intrusive_ptr_release(previous);
+        }
+
+    private:
+        std::atomic <Snapshot const*> current_; // owns one reference.
+        std::atomic <unsigned> epoch_; // selects the counter new readers use.
+        mutable std::atomic <std::size_t> acquiring_[2]; // readers between loading current_ and referencing it.
+        std::mutex publishLock_;
+    };
+
+} // namespace Rest
@@ -8,13 +8,16 @@ namespace Rest
 //#######################################################################################################
     std::vector <std::unique_ptr <PathPart>> Url::parsePath(bool disableIds) const
     {
+        if (path.empty() || path == "/")
+            return {};
+
         std::deque <std::string> splitted;
         boost::algorithm::split(splitted, path, [](char c) {return c == '/';});
         splitted.pop_front();
 
         std::vector <std::unique_ptr <PathPart>> splitPath;
         for (auto const& i : splitted) {
-            if (!disableIds && i.front() == ':')
+            if (!disableIds && !i.empty() && i.front() == ':')
                 splitPath.emplace_back(new PathParameter(i.substr(1, i.length() - 1)));
             else
                 splitPath.emplace_back(new PathString(i));
@@ -4,6 +4,7 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <cstdint>
 
 namespace Rest
 {
@@ -25,7 +26,7 @@ namespace Rest
         std::string url;
         std::string fragment;
         std::string path;
-        std::unordered_map <std::string, std::string> query;
+        std::unordered_map <std::string, std::string> query; // the first value of every key.
 
         std::vector <std::unique_ptr <PathPart>> parsePath(bool disableIds = false) const;
     };
@@ -1,50 +1,118 @@
 #include "url_parser.hpp"
 
-#include <regex>
 #include <stdexcept>
 
 namespace Rest
 {
 //#######################################################################################################
-    void ReducedUrlParser::parseQuery(std::string const& query, Url& url)
+    namespace
     {
-        std::regex rgx( R"((\w+=(?:[\w-])+)(?:(?:&|;)(\w+=(?:[\w-])+))*)" );
-        std::smatch match;
-
-        if (std::regex_match(query, match, rgx))
+        int hexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+    }
+//#######################################################################################################
+    bool ReducedUrlParser::decode(boost::string_view encoded, std::string& out, bool plusAsSpace)
+    {
+        out.reserve(out.size() + encoded.size());
+        for (std::size_t i = 0; i != encoded.size(); ++i)
         {
-            for (auto i = std::begin(match) + 1; i < std::end(match); ++i)
+            auto c = encoded[i];
+            if (c == '%')
             {
-                auto pos = i->str().find_first_of('=');
-                url.query[i->str().substr(pos+1)] = i->str().substr(0, pos);
+                if (encoded.size() - i < 3)
+                    return false;
+                auto high = hexValue(encoded[i + 1]);
+                auto low = hexValue(encoded[i + 2]);
+                if (high < 0 || low < 0)
+                    return false;
+                out.push_back(static_cast <char> (high * 16 + low));
+                i += 2;
             }
+            else if (plusAsSpace && c == '+')
+                out.push_back(' ');
+            else
+                out.push_back(c);
         }
-    }
+        return true;
+    }
 //-------------------------------------------------------------------------------------------------------
-    Url ReducedUrlParser::parse(std::string const& urlString)
+    bool ReducedUrlParser::isValidEncoding(boost::string_view encoded)
     {
-        Url url;
-        url.url = urlString;
+        for (auto percent = encoded.find('%'); percent != boost::string_view::npos; percent = encoded.find('%', percent + 3))
+        {
+            if (encoded.size() - percent < 3 || hexValue(encoded[percent + 1]) < 0 || hexValue(encoded[percent + 2]) < 0)
+                return false;
+        }
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool ReducedUrlParser::decodeQuery(boost::string_view query, std::vector <std::pair <std::string, std::string>>& parameters)
+    {
+        auto valid = true;
+        forEachQueryParameter(query, [&](boost::string_view encodedKey, boost::string_view encodedValue)
+        {
+            std::string key;
+            std::string value;
+            valid = valid && decode(encodedKey, key, true) && decode(encodedValue, value, true);
+            parameters.emplace_back(std::move(key), std::move(value));
+        });
+        return valid;
+    }
+//-------------------------------------------------------------------------------------------------------
+    UrlView ReducedUrlParser::split(boost::string_view urlString)
+    {
+        if (urlString.empty() || urlString.front() != '/')
+            throw std::invalid_argument("Not a valid sub url");
 
-        // regex for extracting path, query, fragment
-        // (?:(?:(\/(?:(?:[a-zA-Z0-9]|[-_~!$&']|[()]|[*+,;=:@])+(?:\/(?:[a-zA-Z0-9]|[-_~!$&']|[()]|[*+,;=:@])+)*)?)|\/)?(?:(\?(?:\w+=(?:[\w-])+)(?:(?:&|;)(?:\w+=(?:[\w-])+))*))?(?:(#(?:\w|\d|=|\(|\)|\\|\/|:|,|&|\?)+))?)
-        std::regex rgx( R"((?:(?:(\/(?:(?:[a-zA-Z0-9]|[-_~!$&']|[()]|[*+,;=:@])+(?:\/(?:[a-zA-Z0-9]|[-_~!$&']|[()]|[*+,;=:@])+)*)?)|\/)?(?:(\?(?:\w+=(?:[\w-])+)(?:(?:&|;)(?:\w+=(?:[\w-])+))*))?(?:(#(?:\w|\d|=|\(|\)|\\|\/|:|,|&|\?)+))?))" );
-        std::smatch match;
+        UrlView view;
+        auto end = urlString.find('#');
+        if (end != boost::string_view::npos)
+            view.fragment = urlString.substr(end + 1);
+        else
+            end = urlString.size();
 
-        if (std::regex_match(urlString, match, rgx))
+        auto question = urlString.substr(0, end).find('?');
+        if (question != boost::string_view::npos)
         {
-            for (auto i = std::begin(match) + 1; i < std::end(match); ++i)
-            {
-                if (i->str().front() == '/')
-                    url.path = i->str();
-                else if (i->str().front() == '?')
-                    ReducedUrlParser::parseQuery(i->str().substr(1, i->str().length() - 1), url);
-                else if (i->str().front() == '#')
-                    url.fragment = i->str().substr(1, i->str().length() - 1);
-            }
+            view.query = urlString.substr(question + 1, end - question - 1);
+            end = question;
         }
-        else
-            throw std::invalid_argument("Not a valid sub url");
+
+        view.path = urlString.substr(0, end);
+        return view;
+    }
+//-------------------------------------------------------------------------------------------------------
+    Url ReducedUrlParser::parse(boost::string_view urlString)
+    {
+        return parse(urlString, split(urlString));
+    }
+//-------------------------------------------------------------------------------------------------------
+    Url ReducedUrlParser::parse(boost::string_view urlString, UrlView const& view)
+    {
+        Url url;
+        url.url = urlString.to_string();
+        url.path = view.path.to_string();
+        if (!decode(view.fragment, url.fragment))
+            throw std::invalid_argument("Invalid percent-encoding in url fragment");
+
+        forEachQueryParameter(view.query, [&url](boost::string_view encodedKey, boost::string_view encodedValue)
+        {
+            std::string key;
+            std::string value;
+            if (!decode(encodedKey, key, true) || !decode(encodedValue, value, true))
+                throw std::invalid_argument("Invalid percent-encoding in url query");
+
+            // the map keeps the first value of repeated keys.
+            url.query.emplace(std::move(key), std::move(value));
+        });
 
         return url;
     }
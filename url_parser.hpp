@@ -2,12 +2,27 @@
 
 #include "url.hpp"
 
+#include <boost/utility/string_view.hpp>
+
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <cstdint>
 
 namespace Rest
 {
+    /**
+     *  The parts of a request target, still percent-encoded.
+     *  Views into the target that was split.
+     */
+    struct UrlView
+    {
+        boost::string_view path;
+        boost::string_view query; // without '?'
+        boost::string_view fragment; // without '#'
+    };
+
     /**
      *  This parser starts with /path ... and not with the scheme.
      *  Because our Rest InterfaceProvider needs it that way.
@@ -17,10 +32,69 @@ namespace Rest
     public:
         /**
          *  parses a urlString to an url object.
+         *  Query keys and values and the fragment are percent-decoded, the path is kept as sent.
+         *
+         *  @throw std::invalid_argument if the url does not start with '/' or contains broken percent-encoding.
+         */
+        static Url parse(boost::string_view urlString);
+
+        /**
+         *  Like parse, for a target that was split already, so that it is not scanned again.
+         *
+         *  @param view The result of split(urlString).
+         */
+        static Url parse(boost::string_view urlString, UrlView const& view);
+
+        /**
+         *  Splits a target into path, query and fragment in a single pass, without copying or decoding.
+         *
+         *  @throw std::invalid_argument if the url does not start with '/'.
          */
-        static Url parse(std::string const& urlString);
+        static UrlView split(boost::string_view urlString);
 
-    private:
-        static void parseQuery(std::string const& query, Url& url);
+        /**
+         *  Calls visitor(key, value) for every key=value pair of a query, in order.
+         *  Pairs are separated by '&' or ';'. A key without '=' has an empty value, empty pairs are skipped.
+         *  Keys and values are passed as sent, use decode on them.
+         */
+        template <typename VisitorT>
+        static void forEachQueryParameter(boost::string_view query, VisitorT&& visitor)
+        {
+            while (!query.empty())
+            {
+                auto end = query.find_first_of("&;");
+                auto pair = query.substr(0, end);
+                query = end == boost::string_view::npos ? boost::string_view{} : query.substr(end + 1);
+                if (pair.empty())
+                    continue;
+
+                auto equals = pair.find('=');
+                if (equals == boost::string_view::npos)
+                    visitor(pair, boost::string_view{});
+                else
+                    visitor(pair.substr(0, equals), pair.substr(equals + 1));
+            }
+        }
+
+        /**
+         *  Decodes all key=value pairs of a query, in order and including repeated keys.
+         *
+         *  @return false if the encoding is broken, some values are incomplete then.
+         */
+        static bool decodeQuery(boost::string_view query, std::vector <std::pair <std::string, std::string>>& parameters);
+
+        /**
+         *  Checks the percent-encoding of a part of an url without decoding it.
+         */
+        static bool isValidEncoding(boost::string_view encoded);
+
+        /**
+         *  Percent-decodes a part of an url and appends it to out.
+         *
+         *  @param plusAsSpace Decode '+' as space, as done in queries.
+         *
+         *  @return false if the encoding is broken, out is incomplete then.
+         */
+        static bool decode(boost::string_view encoded, std::string& out, bool plusAsSpace = false);
     };
 }
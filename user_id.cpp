@@ -1,4 +1,4 @@
-#include "user_Id.hpp"
+#include "user_id.hpp"
 
 #include <functional>
 
@@ -0,0 +1,128 @@
+#include "worker_pool.hpp"
+
+namespace Rest
+{
+//#######################################################################################################
+    WorkerPool::WorkerPool(std::size_t workerCount, std::size_t queueDepth, std::function <void(RestConnection*)> work)
+        : queue_(queueDepth)
+        , work_(std::move(work))
+        , workers_()
+        , running_(true)
+        , idle_(0)
+        , waitingForSpace_(0)
+        , sleepLock_()
+        , wakeUp_()
+        , spaceLock_()
+        , spaceFreed_()
+    {
+        workers_.reserve(workerCount);
+        for (std::size_t i = 0; i != workerCount; ++i)
+            workers_.emplace_back([this]() { run(); });
+    }
+//-------------------------------------------------------------------------------------------------------
+    WorkerPool::~WorkerPool()
+    {
+        stop([](RestConnection*) {});
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool WorkerPool::push(RestConnection* connection)
+    {
+        // a full queue means every worker is busy, let the accepting thread wait until one takes a connection.
+        while (!queue_.bounded_push(connection))
+        {
+            std::unique_lock <std::mutex> guard (spaceLock_);
+            waitingForSpace_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // look again after announcing the wait, or we might miss the worker's signal.
+            auto pushed = queue_.bounded_push(connection);
+            if (!pushed && running_.load())
+                spaceFreed_.wait(guard);
+            waitingForSpace_.fetch_sub(1);
+
+            if (pushed)
+                break;
+            if (!running_.load())
+                return false;
+        }
+
+        // pairs with the fence in run(). Either we see the sleeper or the sleeper sees the connection.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle_.load() > 0)
+        {
+            std::lock_guard <std::mutex> guard (sleepLock_);
+            wakeUp_.notify_one();
+        }
+        return true;
+    }
+//-------------------------------------------------------------------------------------------------------
+    void WorkerPool::stop(std::function <void(RestConnection*)> const& discard)
+    {
+        // LOCK_SCOPE
+        {
+            std::lock_guard <std::mutex> guard (sleepLock_);
+            running_.store(false);
+            wakeUp_.notify_all();
+        }
+        // LOCK_SCOPE
+        {
+            std::lock_guard <std::mutex> guard (spaceLock_);
+            spaceFreed_.notify_all();
+        }
+
+        for (auto& worker : workers_)
+            if (worker.joinable())
+                worker.join();
+        workers_.clear();
+
+        RestConnection* connection = nullptr;
+        while (queue_.pop(connection))
+            discard(connection);
+    }
+//-------------------------------------------------------------------------------------------------------
+    void WorkerPool::run()
+    {
+        RestConnection* connection = nullptr;
+        while (running_.load())
+        {
+            if (take(connection))
+            {
+                work_(connection);
+                continue;
+            }
+
+            std::unique_lock <std::mutex> guard (sleepLock_);
+            idle_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // look again after announcing that we are about to sleep, or we might miss a push.
+            if (take(connection))
+            {
+                idle_.fetch_sub(1);
+                guard.unlock();
+                work_(connection);
+                continue;
+            }
+
+            if (running_.load())
+                wakeUp_.wait(guard);
+            idle_.fetch_sub(1);
+        }
+    }
+//-------------------------------------------------------------------------------------------------------
+    bool WorkerPool::take(RestConnection*& connection)
+    {
+        if (!queue_.pop(connection))
+            return false;
+
+        // pairs with the fence in push(). Either we see the waiting pusher or it sees the free space.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waitingForSpace_.load() > 0)
+        {
+            std::lock_guard <std::mutex> guard (spaceLock_);
+            spaceFreed_.notify_one();
+        }
+        return true;
+    }
+//#######################################################################################################
+} // namespace Rest
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "forward.hpp"
+
+#include <boost/lockfree/queue.hpp>
+
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+
+namespace Rest {
+
+    /**
+     *  A fixed size pool of worker threads that serve accepted connections.
+     *  Connections are handed from the accepting thread to the workers over a
+     *  bounded lock-free queue. Workers only sleep when there is nothing to do.
+     */
+    class WorkerPool
+    {
+    public:
+        /**
+         *  Starts the worker threads.
+         *
+         *  @param workerCount Amount of threads. Must be greater than 0.
+         *  @param queueDepth Maximum amount of connections waiting for a worker.
+         *  @param work The function every worker calls for a connection it took from the queue.
+         */
+        WorkerPool(std::size_t workerCount, std::size_t queueDepth, std::function <void(RestConnection*)> work);
+
+        /**
+         *  Stops and joins all workers. See stop.
+         */
+        ~WorkerPool();
+
+        // not copyable
+        WorkerPool(WorkerPool const&) = delete;
+        WorkerPool& operator=(WorkerPool const&) = delete;
+
+        /**
+         *  Hands a connection to the workers.
+         *  Blocks while the queue is full, until a worker takes a connection out of it.
+         *
+         *  @return false if the pool has been stopped and the connection was not queued.
+         */
+        bool push(RestConnection* connection);
+
+        /**
+         *  Lets the workers finish their current connection and joins them.
+         *  Connections still waiting in the queue are passed to the discard function.
+         */
+        void stop(std::function <void(RestConnection*)> const& discard);
+
+    private:
+        void run();
+
+        /**
+         *  Pops a connection and wakes a pusher waiting for space.
+         */
+        bool take(RestConnection*& connection);
+
+    private:
+        boost::lockfree::queue <RestConnection*> queue_; // accepted connections waiting for a worker.
+        std::function <void(RestConnection*)> work_; // what a worker does with a connection.
+
+        std::vector <std::thread> workers_;
+        std::atomic_bool running_;
+        std::atomic <std::size_t> idle_; // amount of sleeping workers.
+        std::atomic <std::size_t> waitingForSpace_; // amount of pushers waiting for a full queue.
+
+        std::mutex sleepLock_; // only used for sleeping, never held while working.
+        std::condition_variable wakeUp_;
+        std::mutex spaceLock_; // only used by pushers waiting for space.
+        std::condition_variable spaceFreed_;
+    };
+
+} // namespace Rest